@@ -0,0 +1,122 @@
+#include "AggregateHistory.h"
+
+#include <algorithm>	// for upper_bound
+#include <sstream>
+#include "Clock.h"
+#include "OrderSnapshot.h"
+
+using namespace std;
+
+AggregateHistory::AggregateHistory(OrderManager& target, unsigned checkpointInterval, unsigned baseInterval)
+	: target(target), checkpointInterval(checkpointInterval), baseInterval(baseInterval == 0 ? 1 : baseInterval), wallClockOffset(wallClockNanos() - nowNanos())
+{
+	takeCheckpoint();
+}
+
+void AggregateHistory::takeCheckpoint()
+{
+	// a base every baseInterval checkpoints, or right after a reset of target
+	bool base = checkpoints.empty() || checkpointsSinceBase == baseInterval || target.requiresBaseCheckpoint();
+	checkpointsSinceBase = base ? 1 : checkpointsSinceBase + 1;
+	ostringstream out;
+	OrderSnapshot::write(target, out, base ? SnapshotKind::Base : SnapshotKind::Delta);
+	checkpoints.push_back({ events.size(), base, out.str() });
+}
+
+OrderStatus AggregateHistory::record(const EventRecord& event, uint64_t timestamp)
+{
+	if (target.requiresBaseCheckpoint())
+		takeCheckpoint();
+
+	events.push_back(event);
+	timestamps.push_back(timestamp);
+	OrderStatus status;
+	target.applyEvents(&event, 1, &status);
+
+	if (checkpointInterval != 0 && events.size() % checkpointInterval == 0)
+		takeCheckpoint();
+	return status;
+}
+
+void AggregateHistory::checkpoint()
+{
+	if (checkpoints.back().sequence != events.size() || target.requiresBaseCheckpoint())
+		takeCheckpoint();
+}
+
+bool AggregateHistory::queryAtSequence(uint64_t sequence, AggregateSnapshot& result)
+{
+	if (sequence > events.size())
+		return false;
+
+	// last checkpoint at or before sequence; the first one is at sequence 0
+	auto after = upper_bound(checkpoints.begin(), checkpoints.end(), sequence, [](uint64_t value, const Checkpoint& checkpoint) { return value < checkpoint.sequence; });
+	size_t nearest = static_cast<size_t>(after - checkpoints.begin()) - 1;
+	size_t base = nearest;
+	while (!checkpoints[base].base)
+		--base;
+
+	for (size_t i = base; i <= nearest; ++i)
+	{
+		istringstream in(checkpoints[i].data);
+		if (!OrderSnapshot::read(replay, in))
+			return false;
+	}
+
+	uint64_t from = checkpoints[nearest].sequence;
+	replay.applyEvents(events.data() + from, static_cast<size_t>(sequence - from), nullptr);
+	result = replay.Snapshot();
+	return true;
+}
+
+bool AggregateHistory::queryAtTime(uint64_t timestamp, AggregateSnapshot& result)
+{
+	uint64_t sequence = upper_bound(timestamps.begin(), timestamps.end(), timestamp) - timestamps.begin();
+	return queryAtSequence(sequence, result);
+}
+
+OrderStatus AggregateHistory::OnInsertOrderRequest(const OrderKey& id, char side, double price, int quantity) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Insert;
+	event.id = id;
+	event.side = side;
+	event.price = price;
+	event.quantity = quantity;
+	return record(event, now());
+}
+
+OrderStatus AggregateHistory::OnReplaceOrderRequest(const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Replace;
+	event.id = oldId;
+	event.newId = newId;
+	event.deltaQuantity = deltaQuantity;
+	return record(event, now());
+}
+
+OrderStatus AggregateHistory::OnRequestAcknowledged(const OrderKey& id) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Acknowledge;
+	event.id = id;
+	return record(event, now());
+}
+
+OrderStatus AggregateHistory::OnRequestRejected(const OrderKey& id) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Reject;
+	event.id = id;
+	return record(event, now());
+}
+
+OrderStatus AggregateHistory::OnOrderFilled(const OrderKey& id, int quantityFilled) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Fill;
+	event.id = id;
+	event.quantity = quantityFilled;
+	return record(event, now());
+}
@@ -0,0 +1,93 @@
+#ifndef AGGREGATEHISTORY_H
+#define AGGREGATEHISTORY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "EventRecord.h"
+#include "OrderManager.h"
+
+/* Description - Decorator answering point-in-time queries ("what was POV_max on the bid side at 10:31:07.123?").
+	 Every event is timestamped and kept in an in-memory journal with its OrderKey ids, then forwarded to target.
+	 Every checkpointInterval events a checkpoint of target is kept in memory, a base every baseInterval checkpoints and deltas in between.
+	 A query restores the nearest checkpoint at or before the requested point into a private manager and replays at most
+	 checkpointInterval - 1 events from the journal, so it costs one base, a few deltas and a short replay instead of a full-day replay.
+
+	 Checkpoints are serialised on the thread that records the events: a delta costs O(orders changed since the previous checkpoint),
+	 a base O(all orders), paid by the event that triggers it. To keep that off the event path, construct the history with
+	 checkpointInterval 0 and call checkpoint() from the idle or timer path of the event loop instead; queries then replay
+	 the events since the last checkpoint taken.
+   Assumptions -
+	 1. The history takes the checkpoints of target, which clears its dirty set: target must not also be checkpointed by a CheckpointChain.
+	 2. Events reach target only through the history once it is constructed; the state target already holds is the base at sequence 0.
+	    target may be reset with resetSession() between events: the next event (or checkpoint()) first takes a base of the empty book,
+	    so no query replays across the reset.
+	 3. Timestamps are wall-clock nanoseconds since the Unix epoch (see wallClockNanos()), non-decreasing. Unless given to record(),
+	    they are taken from the monotonic clock plus the wall-clock offset measured at construction, so a system clock
+	    adjustment during the session does not reorder them.
+*/
+class AggregateHistory : public Listener, public OrderKeyListener
+{
+	struct Checkpoint
+	{
+		uint64_t sequence;	// events applied when it was taken
+		bool base;
+		std::string data;
+	};
+
+	OrderManager& target;
+	unsigned checkpointInterval;
+	unsigned baseInterval;
+	std::vector<EventRecord> events;
+	std::vector<uint64_t> timestamps;
+	std::vector<Checkpoint> checkpoints;
+	unsigned checkpointsSinceBase = 0;	// including the last base
+	OrderManager replay;
+	uint64_t wallClockOffset;	// wallClockNanos() - nowNanos() at construction, modulo 2^64
+
+	uint64_t now() const { return nowNanos() + wallClockOffset; }
+
+	void takeCheckpoint();
+
+public:
+	/* Description - checkpointInterval 0 takes checkpoints only when checkpoint() is called.
+	*/
+	AggregateHistory(OrderManager& target, unsigned checkpointInterval = 10000, unsigned baseInterval = 16);
+
+	/* Description - Forwards event to target and journals it with timestamp (wall-clock nanoseconds). Returns the status target gives it.
+	*/
+	OrderStatus record(const EventRecord& event, uint64_t timestamp);
+
+	/* Description - Number of events recorded so far.
+	*/
+	uint64_t getSequence() const { return events.size(); }
+
+	/* Description - Takes a checkpoint of target now, unless one was taken after the last event. O(orders changed), or O(all orders)
+		 for a base, so it is meant for the idle or timer path.
+	*/
+	void checkpoint();
+
+	/* Description - Aggregates of target after the first sequence events (0 being the state at construction), or after the reset of
+		 target that followed them.
+		 Returns false when sequence is beyond the events recorded so far or a checkpoint can not be read back.
+	*/
+	bool queryAtSequence(uint64_t sequence, AggregateSnapshot& result);
+
+	/* Description - Aggregates of target after every event recorded at or before timestamp, in wall-clock nanoseconds since the Unix epoch.
+	*/
+	bool queryAtTime(uint64_t timestamp, AggregateSnapshot& result);
+
+	virtual OrderStatus OnInsertOrderRequest(const OrderKey& id, char side, double price, int quantity) noexcept override;
+	virtual OrderStatus OnReplaceOrderRequest(const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept override;
+	virtual OrderStatus OnRequestAcknowledged(const OrderKey& id) noexcept override;
+	virtual OrderStatus OnRequestRejected(const OrderKey& id) noexcept override;
+	virtual OrderStatus OnOrderFilled(const OrderKey& id, int quantityFilled) noexcept override;
+
+	virtual void OnInsertOrderRequest(int id, char side, double price, int quantity) override { OnInsertOrderRequest(OrderKey(id), side, price, quantity); }
+	virtual void OnReplaceOrderRequest(int oldId, int newId, int deltaQuantity) override { OnReplaceOrderRequest(OrderKey(oldId), OrderKey(newId), deltaQuantity); }
+	virtual void OnRequestAcknowledged(int id) override { OnRequestAcknowledged(OrderKey(id)); }
+	virtual void OnRequestRejected(int id) override { OnRequestRejected(OrderKey(id)); }
+	virtual void OnOrderFilled(int id, int quantityFilled) override { OnOrderFilled(OrderKey(id), quantityFilled); }
+};
+
+#endif // !AGGREGATEHISTORY_H
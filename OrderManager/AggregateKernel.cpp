@@ -0,0 +1,223 @@
+#include "AggregateKernel.h"
+#include "OrderManager.h"
+
+#include <cstring>	// for memcpy
+#include <emmintrin.h>	// SSE2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+void OrderColumns::clear()
+{
+	price.clear();
+	remaining.clear();
+	filled.clear();
+	minDelta.clear();
+	maxDelta.clear();
+	flags.clear();
+}
+
+void OrderColumns::reserve(size_t orders)
+{
+	price.reserve(orders);
+	remaining.reserve(orders);
+	filled.reserve(orders);
+	minDelta.reserve(orders);
+	maxDelta.reserve(orders);
+	flags.reserve(orders);
+}
+
+void OrderColumns::push(double orderPrice, int orderRemaining, int orderFilled, int orderMinDelta, int orderMaxDelta, uint8_t orderFlags)
+{
+	price.push_back(orderPrice);
+	remaining.push_back(orderRemaining);
+	filled.push_back(orderFilled);
+	minDelta.push_back(orderMinDelta);
+	maxDelta.push_back(orderMaxDelta);
+	flags.push_back(orderFlags);
+}
+
+namespace
+{
+	// per side sums: [0] offer, [1] bid
+	struct Sums
+	{
+		double cov[2] = { 0.0, 0.0 };
+		double povMin[2] = { 0.0, 0.0 };
+		double povMax[2] = { 0.0, 0.0 };
+		double filled[2] = { 0.0, 0.0 };
+	};
+
+	void accumulateScalar(const OrderColumns& columns, size_t begin, size_t end, Sums& sums)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			int side = columns.flags[i] & ColumnBuy;
+			double price = columns.price[i];
+			sums.filled[side] += columns.filled[i];
+			if (columns.flags[i] & ColumnConfirmed)
+				sums.cov[side] += price * columns.remaining[i];
+			if (columns.flags[i] & ColumnPending)
+			{
+				sums.povMin[side] += price * (columns.remaining[i] + columns.minDelta[i]);
+				sums.povMax[side] += price * (columns.remaining[i] + columns.maxDelta[i]);
+			}
+		}
+	}
+
+#if defined(__AVX2__)
+	const size_t Lanes = 4;
+
+	double horizontalSum(__m256d v)
+	{
+		__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+	}
+
+	size_t accumulateVector(const OrderColumns& columns, Sums& sums)
+	{
+		const double* price = columns.price.data();
+		const int32_t* remaining = columns.remaining.data();
+		const int32_t* filled = columns.filled.data();
+		const int32_t* minDelta = columns.minDelta.data();
+		const int32_t* maxDelta = columns.maxDelta.data();
+		const uint8_t* flags = columns.flags.data();
+
+		const __m256i buyBit = _mm256_set1_epi64x(ColumnBuy);
+		const __m256i pendingBit = _mm256_set1_epi64x(ColumnPending);
+		const __m256i confirmedBit = _mm256_set1_epi64x(ColumnConfirmed);
+
+		__m256d cov[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+		__m256d povMin[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+		__m256d povMax[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+		__m256d fills[2] = { _mm256_setzero_pd(), _mm256_setzero_pd() };
+
+		size_t count = columns.size() / Lanes * Lanes;
+		for (size_t i = 0; i < count; i += Lanes)
+		{
+			int32_t flagBytes;
+			memcpy(&flagBytes, flags + i, sizeof(flagBytes));
+			__m256i flag = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(flagBytes));
+			__m256d buy = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(flag, buyBit), buyBit));
+			__m256d pending = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(flag, pendingBit), pendingBit));
+			__m256d confirmed = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(flag, confirmedBit), confirmedBit));
+
+			__m128i remainingQty = _mm_loadu_si128(reinterpret_cast<const __m128i*>(remaining + i));
+			__m256d p = _mm256_loadu_pd(price + i);
+			__m256d covValue = _mm256_and_pd(confirmed, _mm256_mul_pd(p, _mm256_cvtepi32_pd(remainingQty)));
+			__m256d minValue = _mm256_and_pd(pending, _mm256_mul_pd(p, _mm256_cvtepi32_pd(_mm_add_epi32(remainingQty, _mm_loadu_si128(reinterpret_cast<const __m128i*>(minDelta + i))))));
+			__m256d maxValue = _mm256_and_pd(pending, _mm256_mul_pd(p, _mm256_cvtepi32_pd(_mm_add_epi32(remainingQty, _mm_loadu_si128(reinterpret_cast<const __m128i*>(maxDelta + i))))));
+			__m256d filledQty = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(filled + i)));
+
+			cov[1] = _mm256_add_pd(cov[1], _mm256_and_pd(buy, covValue));
+			cov[0] = _mm256_add_pd(cov[0], _mm256_andnot_pd(buy, covValue));
+			povMin[1] = _mm256_add_pd(povMin[1], _mm256_and_pd(buy, minValue));
+			povMin[0] = _mm256_add_pd(povMin[0], _mm256_andnot_pd(buy, minValue));
+			povMax[1] = _mm256_add_pd(povMax[1], _mm256_and_pd(buy, maxValue));
+			povMax[0] = _mm256_add_pd(povMax[0], _mm256_andnot_pd(buy, maxValue));
+			fills[1] = _mm256_add_pd(fills[1], _mm256_and_pd(buy, filledQty));
+			fills[0] = _mm256_add_pd(fills[0], _mm256_andnot_pd(buy, filledQty));
+		}
+
+		for (int side = 0; side < 2; ++side)
+		{
+			sums.cov[side] += horizontalSum(cov[side]);
+			sums.povMin[side] += horizontalSum(povMin[side]);
+			sums.povMax[side] += horizontalSum(povMax[side]);
+			sums.filled[side] += horizontalSum(fills[side]);
+		}
+		return count;
+	}
+#else
+	const size_t Lanes = 2;
+
+	double horizontalSum(__m128d v)
+	{
+		return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+	}
+
+	// 64 bit lane masks of the flag bit, SSE2 has no 64 bit compare so the low 32 bit result is duplicated
+	__m128d laneMask(__m128i flag, __m128i bit)
+	{
+		__m128i low = _mm_cmpeq_epi32(_mm_and_si128(flag, bit), bit);
+		return _mm_castsi128_pd(_mm_shuffle_epi32(low, _MM_SHUFFLE(2, 2, 0, 0)));
+	}
+
+	__m128d loadQuantity(const int32_t* p)
+	{
+		return _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+	}
+
+	size_t accumulateVector(const OrderColumns& columns, Sums& sums)
+	{
+		const double* price = columns.price.data();
+		const int32_t* remaining = columns.remaining.data();
+		const int32_t* filled = columns.filled.data();
+		const int32_t* minDelta = columns.minDelta.data();
+		const int32_t* maxDelta = columns.maxDelta.data();
+		const uint8_t* flags = columns.flags.data();
+
+		const __m128i buyBit = _mm_set1_epi32(ColumnBuy);
+		const __m128i pendingBit = _mm_set1_epi32(ColumnPending);
+		const __m128i confirmedBit = _mm_set1_epi32(ColumnConfirmed);
+
+		__m128d cov[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+		__m128d povMin[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+		__m128d povMax[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+		__m128d fills[2] = { _mm_setzero_pd(), _mm_setzero_pd() };
+
+		size_t count = columns.size() / Lanes * Lanes;
+		for (size_t i = 0; i < count; i += Lanes)
+		{
+			__m128i flag = _mm_set_epi32(0, flags[i + 1], 0, flags[i]);
+			__m128d buy = laneMask(flag, buyBit);
+			__m128d pending = laneMask(flag, pendingBit);
+			__m128d confirmed = laneMask(flag, confirmedBit);
+
+			__m128i remainingQty = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(remaining + i));
+			__m128d p = _mm_loadu_pd(price + i);
+			__m128d covValue = _mm_and_pd(confirmed, _mm_mul_pd(p, _mm_cvtepi32_pd(remainingQty)));
+			__m128d minValue = _mm_and_pd(pending, _mm_mul_pd(p, _mm_cvtepi32_pd(_mm_add_epi32(remainingQty, _mm_loadl_epi64(reinterpret_cast<const __m128i*>(minDelta + i))))));
+			__m128d maxValue = _mm_and_pd(pending, _mm_mul_pd(p, _mm_cvtepi32_pd(_mm_add_epi32(remainingQty, _mm_loadl_epi64(reinterpret_cast<const __m128i*>(maxDelta + i))))));
+			__m128d filledQty = loadQuantity(filled + i);
+
+			cov[1] = _mm_add_pd(cov[1], _mm_and_pd(buy, covValue));
+			cov[0] = _mm_add_pd(cov[0], _mm_andnot_pd(buy, covValue));
+			povMin[1] = _mm_add_pd(povMin[1], _mm_and_pd(buy, minValue));
+			povMin[0] = _mm_add_pd(povMin[0], _mm_andnot_pd(buy, minValue));
+			povMax[1] = _mm_add_pd(povMax[1], _mm_and_pd(buy, maxValue));
+			povMax[0] = _mm_add_pd(povMax[0], _mm_andnot_pd(buy, maxValue));
+			fills[1] = _mm_add_pd(fills[1], _mm_and_pd(buy, filledQty));
+			fills[0] = _mm_add_pd(fills[0], _mm_andnot_pd(buy, filledQty));
+		}
+
+		for (int side = 0; side < 2; ++side)
+		{
+			sums.cov[side] += horizontalSum(cov[side]);
+			sums.povMin[side] += horizontalSum(povMin[side]);
+			sums.povMax[side] += horizontalSum(povMax[side]);
+			sums.filled[side] += horizontalSum(fills[side]);
+		}
+		return count;
+	}
+#endif
+}
+
+AggregateValues computeAggregates(const OrderColumns& columns)
+{
+	Sums sums;
+	size_t done = accumulateVector(columns, sums);
+	accumulateScalar(columns, done, columns.size(), sums);
+
+	AggregateValues values;
+	values.nfq = static_cast<int>(sums.filled[1] - sums.filled[0]);
+	for (int side = 0; side < 2; ++side)
+	{
+		values.cov[side] = sums.cov[side];
+		values.pov_min[side] = sums.povMin[side];
+		values.pov_max[side] = sums.povMax[side];
+	}
+	return values;
+}
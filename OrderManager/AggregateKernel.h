@@ -0,0 +1,38 @@
+#ifndef AGGREGATEKERNEL_H
+#define AGGREGATEKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AggregateValues;
+
+enum OrderColumnFlag : uint8_t { ColumnBuy = 1 << 0, ColumnPending = 1 << 1, ColumnConfirmed = 1 << 2 };
+
+/* Description - Structure-of-arrays view of the orders, holding only what the aggregates are computed from.
+	 minDelta / maxDelta are the pending replace quantity change split by sign (0 unless ReplacePending),
+	 so a pending order contributes price * (remaining + minDelta) to POV_min and price * (remaining + maxDelta) to POV_max.
+*/
+struct OrderColumns
+{
+	std::vector<double> price;
+	std::vector<int32_t> remaining;
+	std::vector<int32_t> filled;
+	std::vector<int32_t> minDelta;
+	std::vector<int32_t> maxDelta;
+	std::vector<uint8_t> flags;	// OrderColumnFlag bits
+
+	size_t size() const { return price.size(); }
+
+	void clear();
+	void reserve(size_t orders);
+	void push(double orderPrice, int orderRemaining, int orderFilled, int orderMinDelta, int orderMaxDelta, uint8_t orderFlags);
+};
+
+/* Description - Computes nfq, cov, pov_min and pov_max from scratch over the columns.
+	 Vectorised with AVX2 (4 orders per step) when the build enables it, SSE2 (2 orders per step) otherwise.
+	 Sums are plain double lane sums, so they agree with the compensated incremental values up to rounding.
+*/
+AggregateValues computeAggregates(const OrderColumns& columns);
+
+#endif // !AGGREGATEKERNEL_H
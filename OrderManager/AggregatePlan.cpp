@@ -0,0 +1,68 @@
+#include "AggregatePlan.h"
+
+using namespace std;
+
+int AggregatePlan::add(const AggregateDefinition& definition)
+{
+	if (find(definition.name) >= 0)
+		return -1;
+
+	names.push_back(definition.name);
+	sides.push_back(definition.sides);
+	states.push_back(definition.states);
+	minPrices.push_back(definition.minPrice);
+	maxPrices.push_back(definition.maxPrice);
+	minQuantities.push_back(definition.minQuantity);
+	maxQuantities.push_back(definition.maxQuantity);
+	quantities.push_back(static_cast<uint8_t>(definition.quantity));
+	notionals.push_back(definition.notional ? 1 : 0);
+	scales.push_back(definition.scale);
+	sums.push_back(CompensatedSum());
+	contributingOrders.push_back(0);
+	return static_cast<int>(names.size() - 1);
+}
+
+int AggregatePlan::find(const string& name) const
+{
+	for (size_t index = 0; index < names.size(); ++index)
+	{
+		if (names[index] == name)
+			return static_cast<int>(index);
+	}
+	return -1;
+}
+
+void AggregatePlan::apply(const Order& order, int sign)
+{
+	unsigned side = (order.Side() == 'B') ? AggregateDefinition::Buy : AggregateDefinition::Sell;
+	unsigned state = AggregateDefinition::stateMask(order.orderState);
+	double price = order.Price();
+	int total = order.TotalQuantity();
+
+	// indexed by AggregateQuantity and by notional
+	const double orderQuantities[4] = { 1.0, static_cast<double>(order.remainingQuantity), static_cast<double>(order.filledQuantity), static_cast<double>(total) };
+	const double factors[2] = { 1.0, price };
+
+	size_t count = names.size();
+	for (size_t index = 0; index < count; ++index)
+	{
+		int passes = ((sides[index] & side) != 0) & ((states[index] & state) != 0)
+			& (price >= minPrices[index]) & (price < maxPrices[index])
+			& (total >= minQuantities[index]) & (total <= maxQuantities[index]);
+		int contribution = sign * passes;
+
+		sums[index].add(contribution * scales[index] * factors[notionals[index]], orderQuantities[quantities[index]]);
+		contributingOrders[index] += contribution;
+		if (contributingOrders[index] == 0)
+			sums[index].reset();
+	}
+}
+
+void AggregatePlan::reset()
+{
+	for (size_t index = 0; index < sums.size(); ++index)
+	{
+		sums[index].reset();
+		contributingOrders[index] = 0;
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef AGGREGATEPLAN_H
+#define AGGREGATEPLAN_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "CompensatedSum.h"
+#include "OrderManager.h"
+
+// quantity of the order summed by an aggregate (One counts orders)
+enum class AggregateQuantity : uint8_t { One, Remaining, Filled, Total };
+
+/* Description - Definition of a custom aggregate: the sum, over the orders passing the filter, of scale * quantity (* price when notional).
+	 e.g. notional per price band    : { "band100", both sides, confirmed states, 100 <= price < 101, Remaining, notional }
+	      orders above a size        : { "large", ..., minQuantity = 1000, One }
+	      bid-side pending quantity  : { "bidPending", Buy, NewPending | ReplacePending, Remaining }
+*/
+struct AggregateDefinition
+{
+	static const unsigned Buy = 1;
+	static const unsigned Sell = 2;
+
+	static unsigned stateMask(OrderState state) { return 1u << static_cast<unsigned>(state); }
+
+	std::string name;
+	unsigned sides = Buy | Sell;
+	unsigned states = ~0u;	// stateMask() of the states counted
+	double minPrice = -std::numeric_limits<double>::infinity();	// inclusive
+	double maxPrice = std::numeric_limits<double>::infinity();	// exclusive, so adjacent bands [100, 101) and [101, 102) do not overlap
+	int minQuantity = std::numeric_limits<int>::min();	// on the total quantity, inclusive
+	int maxQuantity = std::numeric_limits<int>::max();
+	AggregateQuantity quantity = AggregateQuantity::Remaining;
+	bool notional = false;
+	double scale = 1.0;
+};
+
+/* Description - Custom aggregates registered at runtime, compiled into a flat update plan.
+	 Definitions are stored as one array per field, and apply() evaluates every filter with bitwise arithmetic instead of branches,
+	 adding 0 for the definitions an order does not pass, so an order change costs a fixed, predictable loop over the plan.
+	 Maintained incrementally like COV and POV: the contribution of an order is removed before it changes and added after.
+   Assumptions -
+	 1. Definitions are registered at startup, before the first event (or right after resetSession()): orders already tracked are not counted.
+	 2. The values are not part of snapshots or the state hash: OrderSnapshot::read() rebuilds them from the restored orders.
+*/
+class AggregatePlan
+{
+	std::vector<std::string> names;
+	std::vector<unsigned> sides;
+	std::vector<unsigned> states;
+	std::vector<double> minPrices;
+	std::vector<double> maxPrices;
+	std::vector<int> minQuantities;
+	std::vector<int> maxQuantities;
+	std::vector<uint8_t> quantities;
+	std::vector<uint8_t> notionals;
+	std::vector<double> scales;
+
+	std::vector<CompensatedSum> sums;
+	std::vector<int> contributingOrders;	// the sum is exactly 0 when it drops to 0
+
+public:
+	/* Description - Registers definition and returns its index, or -1 when its name is already registered.
+	*/
+	int add(const AggregateDefinition& definition);
+
+	/* Description - Returns the index of the aggregate named name, or -1.
+	*/
+	int find(const std::string& name) const;
+
+	size_t size() const { return names.size(); }
+	const std::string& name(size_t index) const { return names[index]; }
+	long double value(size_t index) const { return sums[index].value(); }
+
+	/* Description - Adds (sign 1) or removes (sign -1) the contribution of order to every aggregate.
+	*/
+	void apply(const Order& order, int sign);
+
+	/* Description - Clears the values, keeping the definitions.
+	*/
+	void reset();
+};
+
+/* Description - Metrics policy maintaining every built-in aggregate plus the custom aggregates of plan.
+*/
+struct PlannedMetrics : AllMetrics
+{
+	AggregatePlan plan;
+
+	void reset() { plan.reset(); }
+	void beforeChange(const Order& order) { plan.apply(order, -1); }
+	void afterChange(const Order& order) { plan.apply(order, 1); }
+};
+
+typedef BasicOrderManager<PlannedMetrics> PlannedOrderManager;
+
+// instantiated in OrderManager.cpp
+extern template class BasicOrderManager<PlannedMetrics>;
+
+#endif // !AGGREGATEPLAN_H
@@ -0,0 +1,22 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+/* Description - Monotonic timestamp in nanoseconds, comparable between processes on the same box.
+*/
+inline uint64_t nowNanos()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/* Description - Wall-clock time in nanoseconds since the Unix epoch (UTC), for timestamps that are compared with time of day.
+	 Not monotonic: it follows adjustments of the system clock.
+*/
+inline uint64_t wallClockNanos()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+#endif // !CLOCK_H
@@ -0,0 +1,63 @@
+#ifndef COMPENSATEDSUM_H
+#define COMPENSATEDSUM_H
+
+/* Description - Double-double accumulator for sums of price * quantity products.
+	 Each product is split into its rounded value and exact rounding error (Dekker's two-product),
+	 and both are added with error-free two-sum, so a session of additions and matching subtractions
+	 does not leave the residue a plain long double accumulator builds up.
+	 Constant time and branch free per add; no FMA needed.
+*/
+class CompensatedSum
+{
+	double high = 0.0;
+	double low = 0.0;
+
+	static void split(double a, double& aHigh, double& aLow)
+	{
+		const double splitter = 134217729.0;	// 2^27 + 1
+		double t = splitter * a;
+		aHigh = t - (t - a);
+		aLow = a - aHigh;
+	}
+
+	void addPair(double x, double xError)
+	{
+		double s = high + x;
+		double v = s - high;
+		double error = (high - (s - v)) + (x - v) + low + xError;
+		high = s + error;
+		low = error - (high - s);
+	}
+
+public:
+	/* Description - Adds price * quantity, including the rounding error of the product.
+	*/
+	void add(double price, double quantity)
+	{
+		double product = price * quantity;
+		double priceHigh, priceLow, quantityHigh, quantityLow;
+		split(price, priceHigh, priceLow);
+		split(quantity, quantityHigh, quantityLow);
+		double productError = ((priceHigh * quantityHigh - product) + priceHigh * quantityLow + priceLow * quantityHigh) + priceLow * quantityLow;
+		addPair(product, productError);
+	}
+
+	void reset(long double value = 0.0)
+	{
+		high = static_cast<double>(value);
+		low = static_cast<double>(value - high);
+	}
+
+	long double value() const { return static_cast<long double>(high) + low; }
+
+	// raw parts, for saving and restoring the exact accumulator state
+	double highPart() const { return high; }
+	double lowPart() const { return low; }
+	void assign(double newHigh, double newLow)
+	{
+		high = newHigh;
+		low = newLow;
+	}
+};
+
+#endif // !COMPENSATEDSUM_H
@@ -0,0 +1,223 @@
+#include "EndOfDayReconciler.h"
+#include "MappedFile.h"
+#include "TextParsing.h"
+
+#include <algorithm>	// for max, sort
+#include <cstdint>
+#include <cstring>	// for memchr
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+	const char* const OrderStateNames[] = { "NEWPENDING", "ACTIVE", "REJECTED", "REPLACEPENDING", "PARTIALLYFILLED", "COMPLETED" };
+
+	bool parseOrderState(const char* p, size_t length, OrderState& state)
+	{
+		for (size_t i = 0; i < sizeof(OrderStateNames) / sizeof(OrderStateNames[0]); ++i)
+		{
+			const char* name = OrderStateNames[i];
+			size_t j = 0;
+			for (; j < length && name[j] != '\0'; ++j)
+			{
+				char c = p[j];
+				if (c >= 'a' && c <= 'z')
+					c = static_cast<char>(c - 'a' + 'A');
+				if (c != name[j])
+					break;
+			}
+			if (j == length && name[j] == '\0')
+			{
+				state = static_cast<OrderState>(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool parseExchangeLine(const char* line, size_t length, ExchangeOrder& order)
+	{
+		const char* field[6];
+		size_t fieldLength[6];
+		size_t count = 0;
+		const char* end = line + length;
+		const char* p = line;
+		while (true)
+		{
+			const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+			if (count == 6)
+				return false;
+			field[count] = p;
+			fieldLength[count] = (comma ? comma : end) - p;
+			++count;
+			if (comma == nullptr)
+				break;
+			p = comma + 1;
+		}
+
+		if (count != 6 || fieldLength[1] != 1)
+			return false;
+		order.side = field[1][0];
+		return OrderKey::parse(field[0], fieldLength[0], order.id) && parsePrice(field[2], fieldLength[2], order.price)
+			&& parseInt(field[3], fieldLength[3], order.remainingQuantity) && parseInt(field[4], fieldLength[4], order.filledQuantity)
+			&& parseOrderState(field[5], fieldLength[5], order.orderState);
+	}
+
+	void parseChunk(const char* text, size_t begin, size_t end, vector<ExchangeOrder>& orders, size_t& malformed)
+	{
+		orders.reserve((end - begin) / 32);	// rough lower bound of the line length
+
+		const char* p = text + begin;
+		const char* chunkEnd = text + end;
+		while (p < chunkEnd)
+		{
+			const char* newline = static_cast<const char*>(memchr(p, '\n', chunkEnd - p));
+			const char* lineEnd = newline ? newline : chunkEnd;
+			size_t length = lineEnd - p;
+			if (length > 0 && p[length - 1] == '\r')
+				--length;
+
+			if (length > 0 && p[0] != '#')
+			{
+				ExchangeOrder order;
+				if (parseExchangeLine(p, length, order))
+					orders.push_back(order);
+				else
+					++malformed;
+			}
+			p = lineEnd + 1;
+		}
+	}
+
+	size_t partitionOf(const OrderKey& id, size_t partitions)
+	{
+		// top bits of the hash, independent of the bucket index the per-partition table takes from the low bits
+		return static_cast<size_t>((static_cast<uint64_t>(OrderKeyHash()(id)) >> 16) % partitions);
+	}
+
+	unsigned resolveThreads(unsigned threads)
+	{
+		return threads != 0 ? threads : max(1u, thread::hardware_concurrency());
+	}
+
+	// runs task(0) .. task(count - 1) on count threads, task(0) on the calling thread
+	template <class Task>
+	void runParallel(size_t count, Task task)
+	{
+		vector<thread> workers;
+		for (size_t i = 1; i < count; ++i)
+			workers.emplace_back(task, i);
+		if (count > 0)
+			task(0);
+		for (thread& worker : workers)
+			worker.join();
+	}
+}
+
+bool EndOfDayReconciler::loadExchangeFile(const string& path, unsigned threads)
+{
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+
+	parseExchangeRecords(file.data(), file.size(), threads);
+	return true;
+}
+
+void EndOfDayReconciler::parseExchangeRecords(const char* text, size_t length, unsigned threads)
+{
+	auto ranges = splitAtLineBoundaries(text, length, resolveThreads(threads));
+	exchangeChunks.assign(ranges.size(), vector<ExchangeOrder>());
+	vector<size_t> malformed(ranges.size(), 0);
+
+	runParallel(ranges.size(), [&](size_t i) { parseChunk(text, ranges[i].first, ranges[i].second, exchangeChunks[i], malformed[i]); });
+
+	malformedLines = 0;
+	for (size_t count : malformed)
+		malformedLines += count;
+}
+
+vector<ReconciliationBreak> EndOfDayReconciler::reconcile(const OrderManager& manager, unsigned threads) const
+{
+	size_t workers = resolveThreads(threads);
+	size_t partitions = workers;
+
+	// Phase 1 - every worker partitions its slice of the manager table and its share of the exchange chunks by id
+	vector<vector<vector<ExchangeOrder>>> managerParts(workers, vector<vector<ExchangeOrder>>(partitions));
+	vector<vector<vector<const ExchangeOrder*>>> exchangeParts(workers, vector<vector<const ExchangeOrder*>>(partitions));
+
+	runParallel(workers, [&](size_t worker)
+	{
+		manager.forEachOrder([&](const Order& order)
+		{
+			ExchangeOrder state = { order.Id(), order.Side(), order.Price(), order.remainingQuantity, order.filledQuantity, order.orderState };
+			managerParts[worker][partitionOf(state.id, partitions)].push_back(state);
+		}, worker, workers);
+
+		for (size_t chunk = worker; chunk < exchangeChunks.size(); chunk += workers)
+		{
+			for (const ExchangeOrder& order : exchangeChunks[chunk])
+				exchangeParts[worker][partitionOf(order.id, partitions)].push_back(&order);
+		}
+	});
+
+	// Phase 2 - every partition builds a hash table of its exchange orders and probes it with the manager orders
+	vector<vector<ReconciliationBreak>> partitionBreaks(partitions);
+
+	runParallel(partitions, [&](size_t partition)
+	{
+		size_t expected = 0;
+		for (size_t worker = 0; worker < workers; ++worker)
+			expected += exchangeParts[worker][partition].size();
+
+		unordered_map<OrderKey, pair<const ExchangeOrder*, bool>, OrderKeyHash> exchange;	// id -> (record, matched)
+		exchange.reserve(expected);
+		for (size_t worker = 0; worker < workers; ++worker)
+		{
+			for (const ExchangeOrder* order : exchangeParts[worker][partition])
+				exchange[order->id] = make_pair(order, false);
+		}
+
+		vector<ReconciliationBreak>& breaks = partitionBreaks[partition];
+		for (size_t worker = 0; worker < workers; ++worker)
+		{
+			for (const ExchangeOrder& order : managerParts[worker][partition])
+			{
+				auto it = exchange.find(order.id);
+				if (it == exchange.end())
+				{
+					if (order.orderState != OrderState::Rejected)
+						breaks.push_back({ order.id, BreakType::MissingAtExchange, 0, ExchangeOrder(), order });
+					continue;
+				}
+
+				const ExchangeOrder& reported = *it->second.first;
+				it->second.second = true;
+
+				unsigned fields = 0;
+				if (reported.remainingQuantity != order.remainingQuantity)
+					fields |= BreakRemaining;
+				if (reported.filledQuantity != order.filledQuantity)
+					fields |= BreakFilled;
+				if (reported.orderState != order.orderState)
+					fields |= BreakState;
+				if (fields != 0)
+					breaks.push_back({ order.id, BreakType::Mismatch, fields, reported, order });
+			}
+		}
+
+		for (const auto& entry : exchange)
+		{
+			if (!entry.second.second)
+				breaks.push_back({ entry.first, BreakType::MissingInManager, 0, *entry.second.first, ExchangeOrder() });
+		}
+	});
+
+	vector<ReconciliationBreak> breaks;
+	for (const auto& part : partitionBreaks)
+		breaks.insert(breaks.end(), part.begin(), part.end());
+	sort(breaks.begin(), breaks.end(), [](const ReconciliationBreak& a, const ReconciliationBreak& b) { return a.id < b.id; });
+	return breaks;
+}
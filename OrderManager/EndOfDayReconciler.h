@@ -0,0 +1,65 @@
+#ifndef ENDOFDAYRECONCILER_H
+#define ENDOFDAYRECONCILER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "OrderManager.h"
+
+struct ExchangeOrder
+{
+	OrderKey id;
+	char side;
+	double price;
+	int remainingQuantity;
+	int filledQuantity;
+	OrderState orderState;
+};
+
+enum class BreakType { MissingInManager, MissingAtExchange, Mismatch };
+
+enum BreakField : unsigned { BreakRemaining = 1 << 0, BreakFilled = 1 << 1, BreakState = 1 << 2 };
+
+struct ReconciliationBreak
+{
+	OrderKey id;
+	BreakType type;
+	unsigned fields;	// BreakField bits, for BreakType::Mismatch
+	ExchangeOrder exchange;	// valid unless MissingAtExchange
+	ExchangeOrder manager;	// valid unless MissingInManager
+};
+
+/* Description - Reconciles the final state of every order in an OrderManager with the exchange's end-of-day drop-copy file.
+	 File format, one order per line: id,side,price,remaining,filled,state
+	   id is parsed as an OrderKey, so numeric and alphanumeric ClOrdIDs are matched alike.
+	   state is an OrderState name (NewPending, Active, Rejected, ReplacePending, PartiallyFilled, Completed), case-insensitive.
+	 Both sides are hash partitioned by id across threads and every partition is joined independently (parallel hash join).
+   Assumptions -
+	 1. Orders are matched on their current id (the new id once a replace is acknowledged).
+	 2. Rejected orders never reached the market, so their absence from the exchange file is not a break.
+	 3. Lines that do not parse are skipped and counted in getMalformedLines().
+*/
+class EndOfDayReconciler
+{
+	std::vector<std::vector<ExchangeOrder>> exchangeChunks;	// one per loading thread
+	size_t malformedLines = 0;
+
+public:
+	/* Description - Loads the exchange file with the given number of threads (0 = one per hardware thread).
+		 Returns false when the file can not be mapped.
+	*/
+	bool loadExchangeFile(const std::string& path, unsigned threads = 0);
+
+	/* Description - Parses exchange records already in memory, same format and threading as loadExchangeFile().
+	*/
+	void parseExchangeRecords(const char* text, size_t length, unsigned threads = 0);
+
+	size_t getMalformedLines() const { return malformedLines; }
+
+	/* Description - Compares the loaded exchange records with manager and returns the breaks ordered by id.
+		 No events may be processed by manager while this runs.
+	*/
+	std::vector<ReconciliationBreak> reconcile(const OrderManager& manager, unsigned threads = 0) const;
+};
+
+#endif // !ENDOFDAYRECONCILER_H
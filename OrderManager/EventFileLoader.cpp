@@ -0,0 +1,171 @@
+#include "EventFileLoader.h"
+#include "MappedFile.h"
+#include "TextParsing.h"
+
+#include <algorithm>	// for copy
+#include <cstring>	// for memchr
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+	struct ChunkResult
+	{
+		vector<EventRecord> events;
+		size_t malformedLines = 0;
+	};
+
+	bool equalsIgnoreCase(const char* p, size_t length, const char* upper)
+	{
+		size_t i = 0;
+		for (; i < length && upper[i] != '\0'; ++i)
+		{
+			char c = p[i];
+			if (c >= 'a' && c <= 'z')
+				c = static_cast<char>(c - 'a' + 'A');
+			if (c != upper[i])
+				return false;
+		}
+		return i == length && upper[i] == '\0';
+	}
+
+	bool parseEventType(const char* p, size_t length, EventType& type)
+	{
+		if (length == 1 || equalsIgnoreCase(p, length, "INSERT") || equalsIgnoreCase(p, length, "REPLACE")
+			|| equalsIgnoreCase(p, length, "ACK") || equalsIgnoreCase(p, length, "REJECT") || equalsIgnoreCase(p, length, "FILL"))
+		{
+			switch (p[0])
+			{
+			case 'I': case 'i': type = EventType::Insert; return true;
+			case 'A': case 'a': type = EventType::Acknowledge; return true;
+			case 'F': case 'f': type = EventType::Fill; return true;
+			case 'X': case 'x': type = EventType::Reject; return true;
+			case 'R': case 'r':
+				// single letter R is Replace, Reject is spelled out or X
+				type = length > 1 && (p[2] == 'J' || p[2] == 'j') ? EventType::Reject : EventType::Replace;
+				return true;
+			default: return false;
+			}
+		}
+		return false;
+	}
+
+	bool parseLine(const char* line, size_t length, EventRecord& event)
+	{
+		// split into at most 7 fields
+		const char* field[7];
+		size_t fieldLength[7] = {};
+		size_t count = 0;
+		const char* end = line + length;
+		const char* p = line;
+		while (true)
+		{
+			const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+			if (count == 7)
+				return false;
+			field[count] = p;
+			fieldLength[count] = (comma ? comma : end) - p;
+			++count;
+			if (comma == nullptr)
+				break;
+			p = comma + 1;
+		}
+
+		event = EventRecord();
+		if (!parseEventType(field[0], fieldLength[0], event.type) || count < 2 || !OrderKey::parse(field[1], fieldLength[1], event.id))
+			return false;
+
+		switch (event.type)
+		{
+		case EventType::Insert:
+			if (count < 5 || fieldLength[2] != 1 || !parsePrice(field[3], fieldLength[3], event.price)
+				|| !parseUnsigned(field[4], fieldLength[4], event.quantity) || event.quantity == 0)
+				return false;
+			event.side = field[2][0];
+			return true;
+		case EventType::Replace:
+			return count >= 7 && OrderKey::parse(field[5], fieldLength[5], event.newId) && parseInt(field[6], fieldLength[6], event.deltaQuantity);
+		case EventType::Fill:
+			return count >= 5 && parseUnsigned(field[4], fieldLength[4], event.quantity) && event.quantity > 0;
+		default:
+			return true;
+		}
+	}
+
+	void parseChunk(const char* text, size_t begin, size_t end, ChunkResult& result)
+	{
+		const char* p = text + begin;
+		const char* chunkEnd = text + end;
+		while (p < chunkEnd)
+		{
+			const char* newline = static_cast<const char*>(memchr(p, '\n', chunkEnd - p));
+			const char* lineEnd = newline ? newline : chunkEnd;
+			size_t length = lineEnd - p;
+			if (length > 0 && p[length - 1] == '\r')
+				--length;
+
+			if (length > 0 && p[0] != '#')
+			{
+				EventRecord event;
+				if (parseLine(p, length, event))
+					result.events.push_back(event);
+				else
+					++result.malformedLines;
+			}
+			p = lineEnd + 1;
+		}
+	}
+}
+
+bool EventFileLoader::load(const string& path, unsigned threads)
+{
+	MappedFile file;
+	if (!file.open(path))
+		return false;
+
+	parse(file.data(), file.size(), threads);
+	return true;
+}
+
+void EventFileLoader::parse(const char* text, size_t length, unsigned threads)
+{
+	events.clear();
+	malformedLines = 0;
+
+	if (threads == 0)
+		threads = max(1u, thread::hardware_concurrency());
+
+	auto ranges = splitAtLineBoundaries(text, length, threads);
+	vector<ChunkResult> results(ranges.size());
+	vector<thread> workers;
+	for (size_t i = 1; i < ranges.size(); ++i)
+		workers.emplace_back(parseChunk, text, ranges[i].first, ranges[i].second, ref(results[i]));
+	if (!ranges.empty())
+		parseChunk(text, ranges[0].first, ranges[0].second, results[0]);
+	for (thread& worker : workers)
+		worker.join();
+
+	// concatenate the chunks in file order, each chunk copied by its own thread
+	vector<size_t> offsets(results.size() + 1, 0);
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		offsets[i + 1] = offsets[i] + results[i].events.size();
+		malformedLines += results[i].malformedLines;
+	}
+	events.resize(offsets.back());
+
+	workers.clear();
+	for (size_t i = 1; i < results.size(); ++i)
+		workers.emplace_back([this, &results, &offsets, i]() { copy(results[i].events.begin(), results[i].events.end(), events.begin() + offsets[i]); });
+	if (!results.empty())
+		copy(results[0].events.begin(), results[0].events.end(), events.begin());
+	for (thread& worker : workers)
+		worker.join();
+}
+
+void EventFileLoader::replay(OrderKeyListener& listener) const
+{
+	for (const EventRecord& event : events)
+		applyEvent(listener, event);
+}
@@ -0,0 +1,43 @@
+#ifndef EVENTFILELOADER_H
+#define EVENTFILELOADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "EventRecord.h"
+
+/* Description - Loads CSV event captures into binary EventRecords, in parallel, and replays them in file order.
+	 One event per line: type,id,side,price,qty,newId,delta
+	   type is I/Insert, R/Replace, A/Ack, X/Reject or F/Fill (case-insensitive); columns the type does not use may be empty.
+	   Fill takes the filled quantity in qty, Replace takes the old id in id. Insert and fill quantities must be positive,
+	   the replace delta may be negative.
+	   Ids are 64-bit integers or strings of up to 15 characters, interned with OrderKey::parse().
+	 The file is memory mapped and split at line boundaries into one chunk per thread; each chunk is parsed in place.
+   Assumptions -
+	 1. Blank lines and lines starting with '#' are ignored.
+	 2. Lines that do not parse (including a header line) are skipped and counted in getMalformedLines().
+*/
+class EventFileLoader
+{
+	std::vector<EventRecord> events;
+	size_t malformedLines = 0;
+
+public:
+	/* Description - Parses the file with the given number of threads (0 = one per hardware thread).
+		 Returns false when the file can not be mapped.
+	*/
+	bool load(const std::string& path, unsigned threads = 0);
+
+	/* Description - Parses text already in memory, same format and threading as load().
+	*/
+	void parse(const char* text, size_t length, unsigned threads = 0);
+
+	const std::vector<EventRecord>& getEvents() const { return events; }
+	size_t getMalformedLines() const { return malformedLines; }
+
+	/* Description - Feeds every loaded event to listener, in file order.
+	*/
+	void replay(OrderKeyListener& listener) const;
+};
+
+#endif // !EVENTFILELOADER_H
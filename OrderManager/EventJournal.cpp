@@ -0,0 +1,120 @@
+#include "EventJournal.h"
+#include "Clock.h"
+
+#include <new>	// for placement new
+
+using namespace std;
+
+bool JournalWriter::create(const string& name, uint32_t capacity)
+{
+	if (capacity == 0 || !memory.create(name, journalSize(capacity)))
+		return false;
+
+	// the region is zero filled, so every entry starts with sequence 0 (empty)
+	header = new (memory.data()) JournalHeader;
+	entries = reinterpret_cast<JournalEntry*>(static_cast<char*>(memory.data()) + sizeof(JournalHeader));
+	header->capacity = capacity;
+	header->writeSequence.store(0, memory_order_relaxed);
+	header->heartbeatNanos.store(nowNanos(), memory_order_relaxed);
+	sequence = 0;
+
+	atomic_thread_fence(memory_order_release);
+	header->magic = JournalMagic;
+	return true;
+}
+
+void JournalWriter::append(const EventRecord& event)
+{
+	if (header == nullptr)
+		return;
+
+	++sequence;
+	JournalEntry& entry = entries[(sequence - 1) % header->capacity];
+
+	// invalidate the slot first, so a lagging reader can not mistake the half-written record for the old event
+	entry.sequence.store(UINT64_MAX, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	entry.record = event;
+	entry.sequence.store(sequence, memory_order_release);
+
+	header->writeSequence.store(sequence, memory_order_release);
+	header->heartbeatNanos.store(nowNanos(), memory_order_relaxed);
+}
+
+void JournalWriter::heartbeat()
+{
+	if (header != nullptr)
+		header->heartbeatNanos.store(nowNanos(), memory_order_relaxed);
+}
+
+void JournalWriter::publishStateHash(const StateHash& hash)
+{
+	if (header == nullptr)
+		return;
+
+	uint64_t lock = header->hashLock.load(memory_order_relaxed);
+	header->hashLock.store(lock + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	header->hashSequence.store(sequence, memory_order_relaxed);
+	header->hashLow.store(hash.low, memory_order_relaxed);
+	header->hashHigh.store(hash.high, memory_order_relaxed);
+
+	header->hashLock.store(lock + 2, memory_order_release);
+}
+
+OrderStatus JournalWriter::OnInsertOrderRequest(const OrderKey& id, char side, double price, int quantity) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Insert;
+	event.id = id;
+	event.side = side;
+	event.price = price;
+	event.quantity = quantity;
+	append(event);
+
+	return target.OnInsertOrderRequest(id, side, price, quantity);
+}
+
+OrderStatus JournalWriter::OnReplaceOrderRequest(const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Replace;
+	event.id = oldId;
+	event.newId = newId;
+	event.deltaQuantity = deltaQuantity;
+	append(event);
+
+	return target.OnReplaceOrderRequest(oldId, newId, deltaQuantity);
+}
+
+OrderStatus JournalWriter::OnRequestAcknowledged(const OrderKey& id) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Acknowledge;
+	event.id = id;
+	append(event);
+
+	return target.OnRequestAcknowledged(id);
+}
+
+OrderStatus JournalWriter::OnRequestRejected(const OrderKey& id) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Reject;
+	event.id = id;
+	append(event);
+
+	return target.OnRequestRejected(id);
+}
+
+OrderStatus JournalWriter::OnOrderFilled(const OrderKey& id, int quantityFilled) noexcept
+{
+	EventRecord event = EventRecord();
+	event.type = EventType::Fill;
+	event.id = id;
+	event.quantity = quantityFilled;
+	append(event);
+
+	return target.OnOrderFilled(id, quantityFilled);
+}
@@ -0,0 +1,93 @@
+#ifndef EVENTJOURNAL_H
+#define EVENTJOURNAL_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "EventRecord.h"
+#include "OrderManager.h"
+#include "SharedMemory.h"
+
+/* Description - Layout of the shared-memory event journal written by the primary and tailed by standby replicas.
+	 The journal is a ring of capacity entries; event n (1-based) lives in entry (n - 1) % capacity.
+	 An entry's sequence is set to n only after the record is written, so readers see either a complete event or none,
+	 and a sequence beyond n tells a reader that it fell more than capacity events behind and lost events.
+	 The writer never waits for readers.
+*/
+const uint32_t JournalMagic = 0x4F4D4A32;	// "OMJ2", entries holding OrderKey ids
+
+struct JournalEntry
+{
+	std::atomic<uint64_t> sequence;
+	EventRecord record;
+};
+
+struct JournalHeader
+{
+	uint32_t magic;
+	uint32_t capacity;
+
+	alignas(64) std::atomic<uint64_t> writeSequence;	// number of events published
+	std::atomic<uint64_t> heartbeatNanos;	// nowNanos() of the last publish or heartbeat
+
+	// state hash of the primary after event hashSequence, under a sequence lock (odd while written)
+	alignas(64) std::atomic<uint64_t> hashLock;
+	std::atomic<uint64_t> hashSequence;
+	std::atomic<uint64_t> hashLow;
+	std::atomic<uint64_t> hashHigh;
+};
+
+inline size_t journalSize(uint32_t capacity)
+{
+	return sizeof(JournalHeader) + static_cast<size_t>(capacity) * sizeof(JournalEntry);
+}
+
+/* Description - Decorator used on the primary: publishes every event to the journal, then forwards it to target.
+	 Events arrive with OrderKey ids (e.g. from FixParser) or with int ids through Listener, which are journaled as integer keys.
+*/
+class JournalWriter : public Listener, public OrderKeyListener
+{
+	OrderKeyListener& target;
+	SharedMemory memory;
+	JournalHeader* header = nullptr;
+	JournalEntry* entries = nullptr;
+	uint64_t sequence = 0;
+
+	void append(const EventRecord& event);
+
+public:
+	explicit JournalWriter(OrderKeyListener& target) : target(target) {}
+
+	/* Description - Creates the named journal holding the last capacity events, returns false when it can not be created.
+	*/
+	bool create(const std::string& name, uint32_t capacity);
+
+	/* Description - Number of events published so far.
+	*/
+	uint64_t getSequence() const { return sequence; }
+
+	/* Description - Refreshes the liveness timestamp while no events are flowing.
+	*/
+	void heartbeat();
+
+	/* Description - Publishes the primary's state hash after the last published event, so replicas can verify they have not diverged.
+	*/
+	void publishStateHash(const StateHash& hash);
+
+	/* Description - Journals the event and returns the status target gives it. Events target ignores are journaled as well,
+		 so replicas apply them and ignore them the same way.
+	*/
+	virtual OrderStatus OnInsertOrderRequest(const OrderKey& id, char side, double price, int quantity) noexcept override;
+	virtual OrderStatus OnReplaceOrderRequest(const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept override;
+	virtual OrderStatus OnRequestAcknowledged(const OrderKey& id) noexcept override;
+	virtual OrderStatus OnRequestRejected(const OrderKey& id) noexcept override;
+	virtual OrderStatus OnOrderFilled(const OrderKey& id, int quantityFilled) noexcept override;
+
+	virtual void OnInsertOrderRequest(int id, char side, double price, int quantity) override { OnInsertOrderRequest(OrderKey(id), side, price, quantity); }
+	virtual void OnReplaceOrderRequest(int oldId, int newId, int deltaQuantity) override { OnReplaceOrderRequest(OrderKey(oldId), OrderKey(newId), deltaQuantity); }
+	virtual void OnRequestAcknowledged(int id) override { OnRequestAcknowledged(OrderKey(id)); }
+	virtual void OnRequestRejected(int id) override { OnRequestRejected(OrderKey(id)); }
+	virtual void OnOrderFilled(int id, int quantityFilled) override { OnOrderFilled(OrderKey(id), quantityFilled); }
+};
+
+#endif // !EVENTJOURNAL_H
@@ -0,0 +1,56 @@
+#ifndef EVENTRECORD_H
+#define EVENTRECORD_H
+
+#include <cstdint>
+#include "OrderKeyListener.h"
+
+enum class EventType : uint8_t { Insert, Replace, Acknowledge, Reject, Fill };
+
+/* Description - Fixed-size binary form of one OrderKeyListener callback, used for loading, journaling and replaying event streams.
+	 Ids are full OrderKeys, so events with string or 64-bit ids are journaled and replayed as they arrived.
+	 Fields not used by the event type are zero.
+	   Insert      : id, side, price, quantity
+	   Replace     : id (old id), newId, deltaQuantity
+	   Acknowledge : id
+	   Reject      : id
+	   Fill        : id, quantity (quantity filled)
+*/
+struct EventRecord
+{
+	EventType type;
+	char side;
+	OrderKey id;
+	double price;
+	int quantity;
+	OrderKey newId;
+	int deltaQuantity;
+};
+
+static_assert(sizeof(EventRecord) == 64, "EventRecord should fill one cache line");
+
+/* Description - Invokes the callback of handler (an OrderKeyListener or OrderManager) matching the event.
+*/
+template <class Handler>
+inline void applyEvent(Handler& handler, const EventRecord& event)
+{
+	switch (event.type)
+	{
+	case EventType::Insert:
+		handler.OnInsertOrderRequest(event.id, event.side, event.price, event.quantity);
+		break;
+	case EventType::Replace:
+		handler.OnReplaceOrderRequest(event.id, event.newId, event.deltaQuantity);
+		break;
+	case EventType::Acknowledge:
+		handler.OnRequestAcknowledged(event.id);
+		break;
+	case EventType::Reject:
+		handler.OnRequestRejected(event.id);
+		break;
+	case EventType::Fill:
+		handler.OnOrderFilled(event.id, event.quantity);
+		break;
+	}
+}
+
+#endif // !EVENTRECORD_H
@@ -0,0 +1,271 @@
+#include "FixParser.h"
+#include "TextParsing.h"
+
+#include <cstdint>
+#include <emmintrin.h>	// SSE2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>	// for _BitScanForward
+#endif
+
+using namespace std;
+
+namespace
+{
+	const char SOH = '\x01';
+
+	enum FixTagBit : unsigned
+	{
+		HasMsgType = 1 << 0,
+		HasClOrdId = 1 << 1,
+		HasOrigClOrdId = 1 << 2,
+		HasSide = 1 << 3,
+		HasPrice = 1 << 4,
+		HasOrderQty = 1 << 5,
+		HasExecType = 1 << 6,
+		HasLastQty = 1 << 7
+	};
+
+#if defined(__AVX2__)
+	const size_t ScanWidth = 32;
+
+	inline void delimiterMasks(const char* p, uint32_t& sohMask, uint32_t& equalsMask)
+	{
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		sohMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(SOH))));
+		equalsMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('='))));
+	}
+#else
+	const size_t ScanWidth = 16;
+
+	inline void delimiterMasks(const char* p, uint32_t& sohMask, uint32_t& equalsMask)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		sohMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(SOH))));
+		equalsMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('='))));
+	}
+#endif
+
+	// scalar version for the tail of the buffer, which may be shorter than ScanWidth
+	inline void delimiterMasks(const char* p, size_t length, uint32_t& sohMask, uint32_t& equalsMask)
+	{
+		sohMask = 0;
+		equalsMask = 0;
+		for (size_t i = 0; i < length; ++i)
+		{
+			sohMask |= static_cast<uint32_t>(p[i] == SOH) << i;
+			equalsMask |= static_cast<uint32_t>(p[i] == '=') << i;
+		}
+	}
+
+	inline unsigned lowestBit(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+	}
+}
+
+size_t FixParser::parse(const char* buffer, size_t length)
+{
+	size_t consumed = 0;
+	size_t fieldStart = 0;
+	size_t equalsPos = 0;
+	bool haveEquals = false;
+
+	const char* msgType = nullptr;
+	size_t msgTypeLength = 0;
+	presentTags = 0;
+
+	for (size_t block = 0; block < length; block += ScanWidth)
+	{
+		uint32_t sohMask, equalsMask;
+		if (length - block >= ScanWidth)
+			delimiterMasks(buffer + block, sohMask, equalsMask);
+		else
+			delimiterMasks(buffer + block, length - block, sohMask, equalsMask);
+
+		// '=' inside a value is not a delimiter, so only the first '=' after each SOH is used
+		uint32_t mask = sohMask | equalsMask;
+		while (mask)
+		{
+			unsigned bit = lowestBit(mask);
+			mask &= mask - 1;
+			size_t pos = block + bit;
+			bool isSoh = (sohMask >> bit) & 1;
+
+			if (!haveEquals)
+			{
+				if (isSoh)
+					fieldStart = pos + 1;	// field without '=', skip it
+				else
+				{
+					equalsPos = pos;
+					haveEquals = true;
+				}
+				continue;
+			}
+			if (!isSoh)
+				continue;
+
+			int tag;
+			const char* value = buffer + equalsPos + 1;
+			size_t valueLength = pos - equalsPos - 1;
+			if (parseUnsigned(buffer + fieldStart, equalsPos - fieldStart, tag))
+			{
+				bool valid = true;
+				switch (tag)
+				{
+				case 35:
+					msgType = value;
+					msgTypeLength = valueLength;
+					presentTags |= HasMsgType;
+					break;
+				case 11:
+					valid = OrderKey::parse(value, valueLength, clOrdId);
+					presentTags |= HasClOrdId;
+					break;
+				case 41:
+					valid = OrderKey::parse(value, valueLength, origClOrdId);
+					presentTags |= HasOrigClOrdId;
+					break;
+				case 54:
+					side = (valueLength == 1 && value[0] == '1') ? 'B' : 'O';
+					presentTags |= HasSide;
+					break;
+				case 44:
+					valid = parsePrice(value, valueLength, price);
+					presentTags |= HasPrice;
+					break;
+				case 38:
+					valid = parseUnsigned(value, valueLength, orderQty);
+					presentTags |= HasOrderQty;
+					break;
+				case 150:
+					execType = valueLength == 1 ? value[0] : '\0';
+					presentTags |= HasExecType;
+					break;
+				case 32:
+					valid = parseUnsigned(value, valueLength, lastQty);
+					presentTags |= HasLastQty;
+					break;
+				case 10:
+				{
+					// CheckSum closes the message
+					OrderStatus status;
+					if (!dispatch(msgType, msgTypeLength, status))
+						++rejectedMessages;
+					else if (status != OrderStatus::Ok)
+					{
+						++failedRequests;
+						lastFailure = status;
+					}
+					consumed = pos + 1;
+					msgType = nullptr;
+					msgTypeLength = 0;
+					presentTags = 0;
+					break;
+				}
+				default:
+					break;
+				}
+				if (!valid)
+					presentTags = 0;	// malformed value, the message can not be mapped
+			}
+
+			fieldStart = pos + 1;
+			haveEquals = false;
+		}
+	}
+	return consumed;
+}
+
+const OrderKey& FixParser::resolve(const OrderKey& id) const
+{
+	auto it = aliases.find(id);
+	return it != aliases.end() ? it->second : id;
+}
+
+bool FixParser::dispatch(const char* msgType, size_t msgTypeLength, OrderStatus& status)
+{
+	if (msgTypeLength != 1)
+		return false;
+
+	switch (msgType[0])
+	{
+	case 'D':
+	{
+		const unsigned required = HasMsgType | HasClOrdId | HasSide | HasPrice | HasOrderQty;
+		if ((presentTags & required) != required)
+			return false;
+		status = listener.OnInsertOrderRequest(clOrdId, side, price, orderQty);
+		return true;
+	}
+	case 'G':
+	{
+		// FIX carries the new total quantity, the manager expects the change
+		const unsigned required = HasMsgType | HasClOrdId | HasOrigClOrdId | HasOrderQty;
+		if ((presentTags & required) != required)
+			return false;
+		const OrderKey& id = resolve(origClOrdId);
+		const Order* order = manager.findOrder(id);
+		status = (order == nullptr) ? OrderStatus::UnknownId : listener.OnReplaceOrderRequest(id, clOrdId, orderQty - order->TotalQuantity());
+		return true;
+	}
+	case '8':
+	{
+		const unsigned required = HasMsgType | HasExecType;
+		if ((presentTags & required) != required)
+			return false;
+		switch (execType)
+		{
+		case '0':
+			if (!(presentTags & HasClOrdId))
+				return false;
+			status = listener.OnRequestAcknowledged(resolve(clOrdId));
+			return true;
+		case '5':
+		{
+			// replace acknowledgement, the manager tracks the order by its original id and FIX by ClOrdID from now on
+			if (!(presentTags & HasOrigClOrdId))
+				return false;
+			OrderKey id = resolve(origClOrdId);
+			status = listener.OnRequestAcknowledged(id);
+			if (status == OrderStatus::Ok && (presentTags & HasClOrdId) && clOrdId != id)
+				aliases[clOrdId] = id;
+			return true;
+		}
+		case '8':
+			if (!(presentTags & HasClOrdId))
+				return false;
+			status = listener.OnRequestRejected(resolve(clOrdId));
+			return true;
+		case '1':
+		case '2':
+		case 'F':
+			if ((presentTags & (HasClOrdId | HasLastQty)) != (HasClOrdId | HasLastQty))
+				return false;
+			status = listener.OnOrderFilled(resolve(clOrdId), lastQty);
+			return true;
+		default:
+			return false;
+		}
+	}
+	case '9':
+	{
+		const unsigned required = HasMsgType | HasOrigClOrdId;
+		if ((presentTags & required) != required)
+			return false;
+		status = listener.OnRequestRejected(resolve(origClOrdId));
+		return true;
+	}
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef FIXPARSER_H
+#define FIXPARSER_H
+
+#include <cstddef>
+#include <unordered_map>
+#include "OrderManager.h"
+
+/* Description - Parses FIX tag=value drop-copy messages and drives the OrderKeyListener callbacks of an OrderManager.
+	 Delimiters (SOH and '=') are located 16 bytes at a time with SSE2 (32 with AVX2 when the build enables it),
+	 and only the tags below are decoded, directly from the buffer without allocation or string conversion.
+
+	 35=D  NewOrderSingle              -> OnInsertOrderRequest(ClOrdID, Side, Price, OrderQty)
+	 35=G  OrderCancelReplaceRequest   -> OnReplaceOrderRequest(OrigClOrdID, ClOrdID, OrderQty - current total quantity)
+	 35=8  ExecutionReport  150=0      -> OnRequestAcknowledged(ClOrdID)
+	                        150=5      -> OnRequestAcknowledged(OrigClOrdID), ClOrdID becomes an alias of the order
+	                        150=8      -> OnRequestRejected(ClOrdID)
+	                        150=1/2/F  -> OnOrderFilled(ClOrdID, LastQty)
+	 35=9  OrderCancelReject           -> OnRequestRejected(OrigClOrdID)
+
+	 The manager keeps tracking a replaced order under the id it was inserted with, while FIX refers to it by the ClOrdID of
+	 the last acknowledged replace. Every id is therefore resolved through aliases (ClOrdID -> original id) before the callback,
+	 so fills, acknowledgements and chained replaces sent after a replace reach the order.
+   Assumptions -
+	 1. ClOrdID and OrigClOrdID are numeric (64-bit) or strings of up to 15 characters, interned into an OrderKey in place.
+	 2. Side 1 (Buy) maps to 'B', every other side to 'O'.
+	 3. A message ends with the CheckSum field (10); the checksum value itself is not verified.
+	 4. Aliases are kept for the session: call reset() together with OrderManager::resetSession().
+*/
+class FixParser
+{
+	const OrderManager& manager;
+	OrderKeyListener& listener;
+
+	size_t rejectedMessages = 0;
+	size_t failedRequests = 0;
+	OrderStatus lastFailure = OrderStatus::Ok;
+
+	// ClOrdID of an acknowledged replace -> id the manager tracks the order under
+	std::unordered_map<OrderKey, OrderKey, OrderKeyHash> aliases;
+
+	const OrderKey& resolve(const OrderKey& id) const;
+
+	// maps the message to a callback and stores its outcome in status, returns false when the message can not be mapped
+	bool dispatch(const char* msgType, size_t msgTypeLength, OrderStatus& status);
+
+	// fields of the message being parsed, reset for every message
+	OrderKey clOrdId;
+	OrderKey origClOrdId;
+	char side;
+	double price;
+	int orderQty;
+	char execType;
+	int lastQty;
+	unsigned presentTags;
+
+public:
+	explicit FixParser(OrderManager& manager) : manager(manager), listener(manager) {}
+
+	/* Description - Drives listener instead, e.g. a JournalWriter or AggregateHistory in front of manager, so events with
+		 string ids are journaled as they arrive. manager is only read (current quantity of a replaced order), and listener
+		 must forward every event to it.
+	*/
+	FixParser(const OrderManager& manager, OrderKeyListener& listener) : manager(manager), listener(listener) {}
+
+	/* Description - Parses every complete message in buffer.
+		 Returns the number of bytes consumed; a trailing partial message is left for the caller to complete with the next receive.
+	*/
+	size_t parse(const char* buffer, size_t length);
+
+	/* Description - Number of messages that could not be mapped (missing tags, ids that do not fit an OrderKey or unknown message types).
+	*/
+	size_t getRejectedMessages() const { return rejectedMessages; }
+
+	/* Description - Number of mapped messages the manager did not apply (status other than Ok), and the status of the last one.
+	*/
+	size_t getFailedRequests() const { return failedRequests; }
+	OrderStatus getLastFailure() const { return lastFailure; }
+
+	/* Description - Drops the aliases of replaced orders, for a new session.
+	*/
+	void reset() { aliases.clear(); }
+};
+
+#endif // !FIXPARSER_H
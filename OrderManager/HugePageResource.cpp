@@ -0,0 +1,184 @@
+#include "HugePageResource.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+using namespace std;
+
+namespace
+{
+	size_t roundUp(size_t size, size_t multiple)
+	{
+		return (size + multiple - 1) / multiple * multiple;
+	}
+
+	void touchPages(char* region, size_t length, size_t pageSize)
+	{
+		volatile char* pages = region;
+		for (size_t offset = 0; offset < length; offset += pageSize)
+			pages[offset] = 0;
+	}
+}
+
+#if defined(_WIN32)
+
+namespace
+{
+	// large pages can only be allocated by a process holding SeLockMemoryPrivilege, which has to be enabled first
+	bool enableLockMemoryPrivilege()
+	{
+		HANDLE token;
+		if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+			return false;
+
+		TOKEN_PRIVILEGES privileges;
+		privileges.PrivilegeCount = 1;
+		privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+		bool enabled = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+			&& AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+			&& GetLastError() == ERROR_SUCCESS;	// ERROR_NOT_ALL_ASSIGNED when the account does not hold it
+		CloseHandle(token);
+		return enabled;
+	}
+}
+
+bool HugePageResource::reserve(size_t size, HugePageSize pageSize, bool prefault)
+{
+	release();
+	(void)pageSize;	// VirtualAlloc only offers the minimum large page size
+
+	size_t largePage = GetLargePageMinimum();
+	if (largePage != 0 && enableLockMemoryPrivilege())
+	{
+		size_t length = roundUp(size, largePage);
+		void* pages = VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (pages != nullptr)
+		{
+			// large pages are locked in memory when allocated, there is nothing left to fault in
+			region = static_cast<char*>(pages);
+			capacity = length;
+			backing = PageBacking::HugePages;
+			return true;
+		}
+	}
+
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	size_t length = roundUp(size, info.dwPageSize);
+	void* pages = VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (pages == nullptr)
+		return false;
+
+	region = static_cast<char*>(pages);
+	capacity = length;
+	backing = PageBacking::StandardPages;
+	if (prefault)
+		touchPages(region, capacity, info.dwPageSize);
+	return true;
+}
+
+void HugePageResource::release()
+{
+	if (region != nullptr)
+		VirtualFree(region, 0, MEM_RELEASE);
+
+	region = nullptr;
+	capacity = 0;
+	used = 0;
+	backing = PageBacking::None;
+}
+
+#else
+
+bool HugePageResource::reserve(size_t size, HugePageSize pageSize, bool prefault)
+{
+	release();
+
+	size_t hugePage = (pageSize == HugePageSize::Size1GB) ? (size_t(1) << 30) : (size_t(2) << 20);
+	size_t length = roundUp(size, hugePage);
+
+#if defined(MAP_HUGETLB)
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+	flags |= ((pageSize == HugePageSize::Size1GB) ? 30 : 21) << MAP_HUGE_SHIFT;
+#endif
+	// huge pages are reserved by mmap itself, so this fails up front when the pool is too small
+	void* pages = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags | (prefault ? MAP_POPULATE : 0), -1, 0);
+	if (pages != MAP_FAILED)
+	{
+		region = static_cast<char*>(pages);
+		capacity = length;
+		backing = PageBacking::HugePages;
+		return true;
+	}
+#endif
+
+	// standard pages, aligned on the huge page size so transparent huge pages can back the whole region;
+	// rounded to 2MB only, not to the 1GB that may have been asked for, so no more than needed is mapped and prefaulted
+	size_t alignment = size_t(2) << 20;
+	length = roundUp(size, alignment);
+	void* mapping = mmap(nullptr, length + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED)
+		return false;
+
+	char* start = static_cast<char*>(mapping);
+	char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(start), alignment));
+	if (aligned != start)
+		munmap(start, aligned - start);
+	if (aligned + length != start + length + alignment)
+		munmap(aligned + length, start + length + alignment - (aligned + length));
+
+	region = aligned;
+	capacity = length;
+	backing = PageBacking::StandardPages;
+#if defined(MADV_HUGEPAGE)
+	if (madvise(region, capacity, MADV_HUGEPAGE) == 0)
+		backing = PageBacking::TransparentHugePages;
+#endif
+
+	if (prefault)
+		touchPages(region, capacity, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+	return true;
+}
+
+void HugePageResource::release()
+{
+	if (region != nullptr)
+		munmap(region, capacity);
+
+	region = nullptr;
+	capacity = 0;
+	used = 0;
+	backing = PageBacking::None;
+}
+
+#endif
+
+void* HugePageResource::do_allocate(size_t size, size_t alignment)
+{
+	size_t offset = roundUp(used, alignment);
+	if (region != nullptr && offset <= capacity && capacity - offset >= size)
+	{
+		used = offset + size;
+		return region + offset;
+	}
+	return fallback->allocate(size, alignment);
+}
+
+void HugePageResource::do_deallocate(void* pointer, size_t size, size_t alignment)
+{
+	// memory inside the region is reclaimed with the whole region
+	uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+	uintptr_t start = reinterpret_cast<uintptr_t>(region);
+	if (region != nullptr && address >= start && address - start < capacity)
+		return;
+	fallback->deallocate(pointer, size, alignment);
+}
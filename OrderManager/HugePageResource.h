@@ -0,0 +1,54 @@
+#ifndef HUGEPAGERESOURCE_H
+#define HUGEPAGERESOURCE_H
+
+#include <cstddef>
+#include <memory_resource>
+
+enum class HugePageSize { Size2MB, Size1GB };
+
+// how the reserved region ended up being backed
+enum class PageBacking { None, HugePages, TransparentHugePages, StandardPages };
+
+/* Description - Memory resource over one region reserved up front on huge pages, to cut the TLB misses of a large order table.
+	 The region is mapped with explicit huge pages (MAP_HUGETLB on Linux, MEM_LARGE_PAGES on Windows) when the system has them available,
+	 and otherwise falls back transparently to standard pages (with transparent huge pages requested on Linux).
+	 Optionally every page is faulted in by reserve(), so the first burst of the session takes no page faults.
+	 Allocations are carved from the region in order; when it is exhausted they go to the fallback resource.
+   Assumptions -
+	 1. Meant as the upstream of a SessionArena or a pool resource, which take large blocks and keep them
+	    (e.g. SessionArena arena(&pages); OrderManager manager(&arena);):
+	    memory given back inside the region is only reclaimed when the resource is destroyed.
+	 2. Windows needs the SeLockMemoryPrivilege for large pages and has no 1GB pages through VirtualAlloc; 2MB large pages are used for both sizes.
+*/
+class HugePageResource : public std::pmr::memory_resource
+{
+	char* region = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+	PageBacking backing = PageBacking::None;
+	std::pmr::memory_resource* fallback;
+
+	void release();
+
+protected:
+	virtual void* do_allocate(size_t size, size_t alignment) override;
+	virtual void do_deallocate(void* pointer, size_t size, size_t alignment) override;
+	virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+	explicit HugePageResource(std::pmr::memory_resource* fallback = std::pmr::new_delete_resource()) : fallback(fallback) {}
+	HugePageResource(const HugePageResource&) = delete;
+	HugePageResource& operator=(const HugePageResource&) = delete;
+	~HugePageResource() { release(); }
+
+	/* Description - Reserves a region of at least size bytes (rounded up to whole pages), faulting every page in when prefault is set.
+		 Must be called before the first allocation. Returns false when no memory could be mapped at all.
+	*/
+	bool reserve(size_t size, HugePageSize pageSize = HugePageSize::Size2MB, bool prefault = true);
+
+	PageBacking getBacking() const { return backing; }
+	size_t getCapacity() const { return capacity; }
+	size_t getUsedBytes() const { return used; }
+};
+
+#endif // !HUGEPAGERESOURCE_H
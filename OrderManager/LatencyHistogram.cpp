@@ -0,0 +1,97 @@
+#include "LatencyHistogram.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>	// for _BitScanReverse64, or _BitScanReverse on 32-bit x86
+#endif
+
+using namespace std;
+
+namespace
+{
+	inline unsigned highestBit(uint64_t value)
+	{
+#if defined(_MSC_VER) && defined(_M_IX86)
+		// no 64-bit scan on 32-bit x86 (the Win32 configurations): scan the high half, then the low one
+		unsigned long index;
+		if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+			return index + 32;
+		_BitScanReverse(&index, static_cast<unsigned long>(value));
+		return index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return static_cast<unsigned>(63 - __builtin_clzll(value));
+#endif
+	}
+}
+
+unsigned LatencyHistogram::bucketOf(uint64_t nanos)
+{
+	if (nanos < SubBuckets)
+		return static_cast<unsigned>(nanos);
+
+	// the bits below the leading one select the linear bucket within its power of two
+	unsigned shift = highestBit(nanos) - SubBucketBits;
+	return (shift + 1) * SubBuckets + static_cast<unsigned>((nanos >> shift) & (SubBuckets - 1));
+}
+
+uint64_t LatencyHistogram::bucketStart(unsigned bucket)
+{
+	if (bucket < SubBuckets)
+		return bucket;
+
+	unsigned shift = bucket / SubBuckets - 1;
+	return static_cast<uint64_t>(SubBuckets + bucket % SubBuckets) << shift;
+}
+
+void LatencyHistogram::record(uint64_t nanos)
+{
+	++counts[bucketOf(nanos)];
+	++total;
+	if (nanos < minimum)
+		minimum = nanos;
+	if (nanos > maximum)
+		maximum = nanos;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+	if (total == 0)
+		return 0;
+
+	uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total));
+	if (rank >= total)
+		rank = total - 1;
+
+	uint64_t seen = 0;
+	for (unsigned bucket = 0; bucket < BucketCount; ++bucket)
+	{
+		seen += counts[bucket];
+		if (seen > rank)
+		{
+			uint64_t end = (bucket + 1 < BucketCount) ? bucketStart(bucket + 1) - 1 : UINT64_MAX;
+			return end < maximum ? end : maximum;
+		}
+	}
+	return maximum;
+}
+
+void LatencyHistogram::reset()
+{
+	for (unsigned bucket = 0; bucket < BucketCount; ++bucket)
+		counts[bucket] = 0;
+	total = 0;
+	minimum = UINT64_MAX;
+	maximum = 0;
+}
+
+void RoundTripLatency::reset()
+{
+	for (auto& request : histograms)
+	{
+		for (LatencyHistogram& histogram : request)
+			histogram.reset();
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cstdint>
+#include "EventRecord.h"
+
+/* Description - Histogram of latencies in nanoseconds over log-linear buckets: each power of two is split in SubBuckets linear buckets,
+	 so any value is counted with a relative error below 1 / SubBuckets, from 1ns to the full 64-bit range, in a fixed 4KB array.
+	 Recording is a bit scan and an increment, without allocation.
+*/
+class LatencyHistogram
+{
+public:
+	static const unsigned SubBucketBits = 3;
+	static const unsigned SubBuckets = 1u << SubBucketBits;
+	static const unsigned BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+private:
+	uint64_t counts[BucketCount] = {};
+	uint64_t total = 0;
+	uint64_t minimum = UINT64_MAX;
+	uint64_t maximum = 0;
+
+	static unsigned bucketOf(uint64_t nanos);
+	static uint64_t bucketStart(unsigned bucket);
+
+public:
+	void record(uint64_t nanos);
+
+	uint64_t getCount() const { return total; }
+	uint64_t getMin() const { return total != 0 ? minimum : 0; }
+	uint64_t getMax() const { return maximum; }
+
+	/* Description - Latency below which fraction (0 to 1) of the recorded values fall, as the upper bound of its bucket. 0 when empty.
+	*/
+	uint64_t percentile(double fraction) const;
+
+	void reset();
+};
+
+/* Description - Venue round-trip latencies (request to acknowledgement or rejection) per request type and side, see OrderManager::setLatencyTracker().
+*/
+class RoundTripLatency
+{
+	LatencyHistogram histograms[2][2];	// [request == Replace][side == 'B']
+
+public:
+	/* Description - request is EventType::Insert or EventType::Replace.
+	*/
+	void record(EventType request, char side, uint64_t nanos) { histograms[request == EventType::Replace][side == 'B'].record(nanos); }
+	const LatencyHistogram& get(EventType request, char side) const { return histograms[request == EventType::Replace][side == 'B']; }
+
+	void reset();
+};
+
+#endif // !LATENCYHISTOGRAM_H
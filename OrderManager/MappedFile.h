@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/* Description - Read-only memory mapping of a whole file, so parsers work directly on the page cache without read() copies.
+*/
+class MappedFile
+{
+	const char* address = nullptr;
+	size_t length = 0;
+#if defined(_WIN32)
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+
+	void close();
+
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { close(); }
+
+	/* Description - Maps the file, returns false when it can not be opened or mapped.
+		 An empty file maps successfully with size() == 0.
+	*/
+	bool open(const std::string& path);
+
+	const char* data() const { return address; }
+	size_t size() const { return length; }
+};
+
+#endif // !MAPPEDFILE_H
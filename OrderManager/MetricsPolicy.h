@@ -0,0 +1,49 @@
+#ifndef METRICSPOLICY_H
+#define METRICSPOLICY_H
+
+class Order;
+
+/* Description - Metrics policy of BasicOrderManager: selects at compile time which built-in aggregates are maintained,
+	 and receives every order change for custom aggregates.
+	 The update of an aggregate that is not selected is discarded by if constexpr, so its arithmetic is not compiled at all;
+	 its getters then return 0. Hooks are called inline after the order has changed, so empty hooks cost nothing.
+	 HASH selects the per-order part of the state hash (BasicOrderManager::getStateHash()), two short digests per event,
+	 which replicas and snapshot checks rely on; it can also be turned off at runtime (setStateHashing()).
+	 A custom policy derives from AllMetrics (or NFQOnlyMetrics), hides the flags and hooks it changes, and is instantiated
+	 at the end of OrderManager.cpp next to the policies below, and at the end of OrderSnapshot.cpp for snapshots and checkpoint chains.
+	 The manager owns one instance, see BasicOrderManager::getMetrics().
+   Assumptions -
+	 1. Hooks are not called for events that are ignored (status other than Ok), nor by resetSession() other than through reset().
+	    OrderSnapshot::read() calls beforeChange / afterChange around every order it restores.
+	 2. The other components built on a manager (StandbyReplica, QueryServer, FixParser, EndOfDayReconciler, AggregateHistory)
+	    take an OrderManager, i.e. AllMetrics: a manager with another policy is driven and checkpointed directly.
+*/
+struct AllMetrics
+{
+	static constexpr bool NFQ = true;
+	static constexpr bool COV = true;
+	static constexpr bool POV = true;
+	static constexpr bool HASH = true;
+
+	void reset() {}
+
+	// around every change of an order, with the order as it is before and after it (afterChange only when it is inserted)
+	void beforeChange(const Order&) {}
+	void afterChange(const Order&) {}
+
+	// after each event, with the order as it is after it
+	void onInsert(const Order&) {}
+	void onReplaceRequest(const Order&, int /*deltaQuantity*/) {}
+	void onAcknowledged(const Order&) {}
+	void onRejected(const Order&) {}
+	void onFill(const Order&, int /*quantityFilled*/) {}
+};
+
+struct NFQOnlyMetrics : AllMetrics
+{
+	static constexpr bool COV = false;
+	static constexpr bool POV = false;
+	static constexpr bool HASH = false;
+};
+
+#endif // !METRICSPOLICY_H
@@ -0,0 +1,32 @@
+#include "OrderAuditTrail.h"
+
+#include <algorithm>	// for reverse
+#include "Clock.h"
+#include "OrderManager.h"
+
+using namespace std;
+
+void OrderAuditTrail::append(Order& order, EventType event, int quantity)
+{
+	if ((count >> ChunkBits) == chunks.size())
+		chunks.emplace_back(new AuditEntry[ChunkSize]);
+
+	AuditEntry& entry = chunks[count >> ChunkBits][count & (ChunkSize - 1)];
+	entry.timestamp = nowNanos();
+	entry.previous = order.auditEntry;
+	entry.event = event;
+	entry.state = static_cast<uint8_t>(order.orderState);
+	entry.quantity = quantity;
+	entry.remainingQuantity = order.remainingQuantity;
+	entry.filledQuantity = order.filledQuantity;
+
+	order.auditEntry = count++;
+}
+
+void OrderAuditTrail::history(const Order& order, vector<AuditEntry>& history) const
+{
+	history.clear();
+	for (uint32_t index = order.auditEntry; index != Order::NoAuditEntry && index < count; index = entry(index).previous)
+		history.push_back(entry(index));
+	reverse(history.begin(), history.end());
+}
@@ -0,0 +1,64 @@
+#ifndef ORDERAUDITTRAIL_H
+#define ORDERAUDITTRAIL_H
+
+#include <cstdint>
+#include <memory>	// for unique_ptr
+#include <vector>
+#include "EventRecord.h"
+
+class Order;
+
+/* Description - One state transition of an order, as recorded in the audit trail.
+	 quantity is the quantity of the event: inserted for Insert, deltaQuantity for Replace, filled for Fill, 0 otherwise.
+	 state, remainingQuantity and filledQuantity are those of the order after the event.
+*/
+struct AuditEntry
+{
+	uint64_t timestamp;	// nowNanos()
+	uint32_t previous;	// previous entry of the same order, Order::NoAuditEntry for the first
+	EventType event;
+	uint8_t state;	// OrderState
+	int quantity;
+	int remainingQuantity;
+	int filledQuantity;
+};
+
+static_assert(sizeof(AuditEntry) == 32, "AuditEntry should stay compact");
+
+/* Description - Append-only log of the state transitions of every order.
+	 Entries are written in event order into fixed-size chunks, so recording an event is one sequential 32 byte write and never moves
+	 earlier entries. Each entry links to the previous entry of the same order, and the order keeps the index of its last one
+	 (Order::auditEntry), so the history of an order is read in O(its length) without scanning the log.
+   Assumptions -
+	 1. A session holds less than 2^32 - 1 entries.
+	 2. reset() keeps the chunks, so the next session appends to memory that is already faulted in.
+*/
+class OrderAuditTrail
+{
+	static const uint32_t ChunkBits = 16;
+	static const uint32_t ChunkSize = 1u << ChunkBits;
+
+	std::vector<std::unique_ptr<AuditEntry[]>> chunks;
+	uint32_t count = 0;
+
+public:
+	/* Description - Appends an entry for event on order, as it is after the event, and links it to the order's history.
+	*/
+	void append(Order& order, EventType event, int quantity);
+
+	/* Description - Entry at index, which must be below getCount().
+	*/
+	const AuditEntry& entry(uint32_t index) const { return chunks[index >> ChunkBits][index & (ChunkSize - 1)]; }
+
+	uint32_t getCount() const { return count; }
+
+	/* Description - Fills history with the entries of order, oldest first.
+	*/
+	void history(const Order& order, std::vector<AuditEntry>& history) const;
+
+	/* Description - Drops every entry. Orders still linked to the trail must be dropped as well (see OrderManager::resetSession()).
+	*/
+	void reset() { count = 0; }
+};
+
+#endif // !ORDERAUDITTRAIL_H
@@ -0,0 +1,104 @@
+#ifndef ORDERKEY_H
+#define ORDERKEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>	// for memcpy
+#include <string>
+
+/* Description - Fixed-width (16 byte) client order id: a 64-bit integer, or a string of up to 15 characters stored inline.
+	 Venue ids of either form are used as they arrive, so there is no translation map in front of the manager:
+	 a lookup is one hash of two words and one probe of the order table, without allocation.
+   Assumptions -
+	 1. Strings are compared byte for byte, so "00123" and "123" are different ids; parse() only treats canonical decimal text as an integer.
+	 2. The layout is host byte order; keys are not portable between machines of different endianness.
+*/
+struct OrderKey
+{
+	uint64_t low;	// the integer id, or the first 8 characters
+	uint64_t high;	// 0 for an integer id, otherwise characters 8 to 14 and 0x80 | length in the last byte
+
+	static const size_t MaxStringLength = 15;
+
+	OrderKey() : low(0), high(0) {}
+	explicit OrderKey(int64_t id) : low(static_cast<uint64_t>(id)), high(0) {}
+
+	/* Description - Interns a string id. Returns false when it is longer than MaxStringLength.
+	*/
+	static bool fromString(const char* text, size_t length, OrderKey& key)
+	{
+		if (length > MaxStringLength)
+			return false;
+
+		unsigned char bytes[16] = {};
+		memcpy(bytes, text, length);
+		bytes[15] = static_cast<unsigned char>(0x80 | length);
+		memcpy(&key.low, bytes, 8);
+		memcpy(&key.high, bytes + 8, 8);
+		return true;
+	}
+
+	/* Description - Converts a venue id: canonical decimal text (no sign other than '-', no leading zeros) that fits
+		 in 64 bits becomes an integer key, anything else a string key. Returns false when it is empty or too long.
+	*/
+	static bool parse(const char* text, size_t length, OrderKey& key)
+	{
+		size_t i = (length > 1 && text[0] == '-') ? 1 : 0;
+		bool canonical = i < length && length - i <= 19 && (text[i] != '0' || length - i == 1);
+		uint64_t magnitude = 0;
+		for (size_t j = i; canonical && j < length; ++j)
+		{
+			unsigned digit = static_cast<unsigned>(text[j] - '0');
+			canonical = digit <= 9;
+			magnitude = magnitude * 10 + digit;
+		}
+		// 19 digits never overflow uint64_t, only int64_t
+		if (canonical && magnitude <= (i ? static_cast<uint64_t>(INT64_MAX) + 1 : static_cast<uint64_t>(INT64_MAX)) && !(i && magnitude == 0))
+		{
+			key.low = i ? 0 - magnitude : magnitude;
+			key.high = 0;
+			return true;
+		}
+		return length > 0 && fromString(text, length, key);
+	}
+
+	bool isInteger() const { return high == 0; }
+	int64_t integer() const { return static_cast<int64_t>(low); }
+
+	// the id as text; keys qualified by OrderManagerHost go through OrderManagerHost::unqualify() first
+	std::string toString() const
+	{
+		if (isInteger())
+			return std::to_string(integer());
+
+		unsigned char bytes[16];
+		memcpy(bytes, &low, 8);
+		memcpy(bytes + 8, &high, 8);
+		return std::string(reinterpret_cast<const char*>(bytes), bytes[15] & 0x0F);	// the length, without the 0x80 / 0x90 marker
+	}
+
+	bool operator==(const OrderKey& other) const { return low == other.low && high == other.high; }
+	bool operator!=(const OrderKey& other) const { return !(*this == other); }
+
+	// total order for sorted reports: integer ids first, by value
+	bool operator<(const OrderKey& other) const
+	{
+		if (high != other.high)
+			return high < other.high;
+		return isInteger() ? integer() < other.integer() : low < other.low;
+	}
+};
+
+/* Description - Hash of an OrderKey for the order tables: the high word is folded in with one multiply
+	 and the result mixed once, so integer ids (high == 0) cost a single multiply and shift.
+*/
+struct OrderKeyHash
+{
+	size_t operator()(const OrderKey& key) const
+	{
+		uint64_t h = (key.low ^ (key.high * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+		return static_cast<size_t>(h ^ (h >> 32));
+	}
+};
+
+#endif // !ORDERKEY_H
@@ -0,0 +1,26 @@
+#ifndef ORDERKEYLISTENER_H
+#define ORDERKEYLISTENER_H
+
+#include <cstdint>
+#include "OrderKey.h"
+
+// Outcome of a handler call. Anything but Ok means the event was ignored and the state is unchanged.
+enum class OrderStatus : uint8_t { Ok, DuplicateId, UnknownId, AlreadyPending, NotPending, FillOnRejected, UnknownTenant, InvalidId };
+
+/* Description - The Listener callbacks with OrderKey ids (64-bit or string, see OrderKey.h), returning the outcome.
+	 Implemented by OrderManager and by the stages in front of it (JournalWriter, AggregateHistory),
+	 so a venue id reaches the journal, the replicas and the history as it arrived, and not only when it fits an int.
+   Assumptions -
+	 1. Handlers are noexcept: failures are reported through OrderStatus.
+*/
+class OrderKeyListener
+{
+public:
+	virtual OrderStatus OnInsertOrderRequest(const OrderKey& id, char side, double price, int quantity) noexcept = 0;
+	virtual OrderStatus OnReplaceOrderRequest(const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept = 0;
+	virtual OrderStatus OnRequestAcknowledged(const OrderKey& id) noexcept = 0;
+	virtual OrderStatus OnRequestRejected(const OrderKey& id) noexcept = 0;
+	virtual OrderStatus OnOrderFilled(const OrderKey& id, int quantityFilled) noexcept = 0;
+};
+
+#endif // !ORDERKEYLISTENER_H
@@ -0,0 +1,89 @@
+#include "OrderLifetimeAnalytics.h"
+#include "OrderManager.h"
+
+using namespace std;
+
+void FillRatioHistogram::record(int filledQuantity, int requestedQuantity)
+{
+	if (requestedQuantity <= 0 || filledQuantity < 0)
+		filledQuantity = 0;
+
+	// the bucket in integers, as ratio * 100 may round below a whole percent (29 / 100 * 100 < 29)
+	unsigned percent = 0;
+	if (filledQuantity > requestedQuantity)
+		percent = Overfilled;
+	else if (filledQuantity > 0)
+		percent = static_cast<unsigned>(static_cast<int64_t>(filledQuantity) * 100 / requestedQuantity);
+	double ratio = (requestedQuantity > 0) ? static_cast<double>(filledQuantity) / requestedQuantity : 0.0;
+
+	++counts[percent];
+	++total;
+	ratioSum += ratio;
+}
+
+unsigned FillRatioHistogram::percentile(double fraction) const
+{
+	if (total == 0)
+		return 0;
+
+	uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total));
+	if (rank >= total)
+		rank = total - 1;
+
+	uint64_t seen = 0;
+	for (unsigned percent = 0; percent < Overfilled; ++percent)
+	{
+		seen += counts[percent];
+		if (seen > rank)
+			return percent;
+	}
+	return Overfilled;
+}
+
+void FillRatioHistogram::reset()
+{
+	for (uint64_t& count : counts)
+		count = 0;
+	total = 0;
+	ratioSum = 0.0;
+}
+
+void OrderLifetimeAnalytics::orderCompleted(const Order& order, uint64_t now)
+{
+	fillRatios.record(order.filledQuantity, order.peakQuantity);
+	replaceCounts.record(order.replaceCount);
+	if (order.insertTimestamp != 0)
+	{
+		timesToCompletion.record(now - order.insertTimestamp);
+		if (order.firstFillTimestamp != 0)
+			timesToFirstFill.record(order.firstFillTimestamp - order.insertTimestamp);
+	}
+	++completedOrders;
+}
+
+void OrderLifetimeAnalytics::orderRejected(const Order& order)
+{
+	fillRatios.record(order.filledQuantity, order.peakQuantity);
+	replaceCounts.record(order.replaceCount);
+	if (order.insertTimestamp != 0 && order.firstFillTimestamp != 0)
+		timesToFirstFill.record(order.firstFillTimestamp - order.insertTimestamp);
+	++rejectedOrders;
+}
+
+void OrderLifetimeAnalytics::orderOpenAtClose(const Order& order)
+{
+	openFillRatios.record(order.filledQuantity, order.peakQuantity);
+	++openOrders;
+}
+
+void OrderLifetimeAnalytics::reset()
+{
+	fillRatios.reset();
+	openFillRatios.reset();
+	timesToFirstFill.reset();
+	timesToCompletion.reset();
+	replaceCounts.reset();
+	completedOrders = 0;
+	rejectedOrders = 0;
+	openOrders = 0;
+}
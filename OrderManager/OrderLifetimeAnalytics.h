@@ -0,0 +1,83 @@
+#ifndef ORDERLIFETIMEANALYTICS_H
+#define ORDERLIFETIMEANALYTICS_H
+
+#include <cstdint>
+#include "LatencyHistogram.h"
+
+class Order;
+
+/* Description - Streaming histogram of fill ratios (filled / peak requested quantity) in whole percents, with one bucket for overfilled orders.
+*/
+class FillRatioHistogram
+{
+public:
+	static const unsigned Overfilled = 101;	// bucket of the orders filled beyond their peak requested quantity
+
+private:
+	uint64_t counts[Overfilled + 1] = {};
+	uint64_t total = 0;
+	double ratioSum = 0.0;
+
+public:
+	void record(int filledQuantity, int requestedQuantity);
+
+	uint64_t getCount() const { return total; }
+	double getMean() const { return total != 0 ? ratioSum / static_cast<double>(total) : 0.0; }
+	uint64_t getCount(unsigned percent) const { return counts[percent]; }
+
+	/* Description - Fill ratio in percent below which fraction (0 to 1) of the orders fall; Overfilled for the overfilled ones, 0 when empty.
+	*/
+	unsigned percentile(double fraction) const;
+
+	void reset();
+};
+
+/* Description - Online order lifetime statistics, see OrderManager::setLifetimeAnalytics().
+	 Each order leaving the book (reaching Completed, or rejected on insert) is summarised once into the histograms,
+	 so fill ratio, time to first fill, time to completion and replace count are reported without post-processing the journal.
+	 The fill ratio is measured against the peak requested quantity (Order::peakQuantity): a completed order has filled its
+	 total quantity by definition, so only an order whose quantity was never reduced reads 100%.
+	 Orders still open when the session ends are summarised separately by resetSession() (getOpenFillRatios()), as they never leave the book.
+	 Times are in nanoseconds from the insert request and are quantile sketches with a relative error below 12.5% (see LatencyHistogram).
+   Assumptions -
+	 1. Orders inserted before the analytics were attached have no insert time: they count in fill ratios and replace counts only.
+	 2. An order reopened by a replace (quantity increased after it completed) is counted again when it completes again.
+	 3. An order restored from a snapshot starts its peak at its restored total quantity.
+*/
+class OrderLifetimeAnalytics
+{
+	FillRatioHistogram fillRatios;
+	FillRatioHistogram openFillRatios;
+	LatencyHistogram timesToFirstFill;
+	LatencyHistogram timesToCompletion;
+	LatencyHistogram replaceCounts;
+	uint64_t completedOrders = 0;
+	uint64_t rejectedOrders = 0;
+	uint64_t openOrders = 0;
+
+public:
+	/* Description - Called by the manager when order reaches Completed at now (nowNanos()).
+	*/
+	void orderCompleted(const Order& order, uint64_t now);
+
+	/* Description - Called by the manager when the insert of order is rejected.
+	*/
+	void orderRejected(const Order& order);
+
+	/* Description - Called by the manager for each order still open (neither Completed nor Rejected) when the session is reset.
+	*/
+	void orderOpenAtClose(const Order& order);
+
+	const FillRatioHistogram& getFillRatios() const { return fillRatios; }
+	const FillRatioHistogram& getOpenFillRatios() const { return openFillRatios; }
+	const LatencyHistogram& getTimesToFirstFill() const { return timesToFirstFill; }
+	const LatencyHistogram& getTimesToCompletion() const { return timesToCompletion; }
+	const LatencyHistogram& getReplaceCounts() const { return replaceCounts; }
+	uint64_t getCompletedOrders() const { return completedOrders; }
+	uint64_t getRejectedOrders() const { return rejectedOrders; }
+	uint64_t getOpenOrders() const { return openOrders; }
+
+	void reset();
+};
+
+#endif // !ORDERLIFETIMEANALYTICS_H
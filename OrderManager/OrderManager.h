@@ -1,84 +1,424 @@
 #ifndef ORDERMANAGER_H
 #define ORDERMANAGER_H
 
+#include <cstdint>
 #include <iostream>
-#include <memory>	// for shared_ptr
+#include <memory>	// for unique_ptr
+#include <memory_resource>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
+#include "AggregateKernel.h"
+#include "Clock.h"
+#include "CompensatedSum.h"
+#include "EventRecord.h"
+#include "LatencyHistogram.h"
+#include "MetricsPolicy.h"
+#include "OrderKey.h"
+#include "OrderLifetimeAnalytics.h"
+#include "OrderAuditTrail.h"
+#include "OrderKeyListener.h"
 #include "OrderListnerInterface.h"
+#include "RequestCompletion.h"
+#include "SessionArena.h"
 
 enum class OrderState { NewPending, Active, Rejected, ReplacePending, PartiallyFilled, Completed };
 
 class Order
 {
-	int id;
-	char side;
+	OrderKey id;
 	double price;
 	int totalQuantity;	// filled + remaining
+	char side;
 public:
+	static const uint32_t NoAuditEntry = 0xFFFFFFFF;
+
 	int remainingQuantity;
 	int filledQuantity;
 	OrderState orderState;
+	bool dirty = false;	// changed since the last checkpoint
+	bool completed = false;	// Completed in its last state that was not pending, see BasicOrderManager::trackCompletion()
+	uint32_t tenant = 0;	// aggregates it contributes to, see OrderManagerHost
+	uint32_t auditEntry = NoAuditEntry;	// last entry of its history, see OrderAuditTrail
+	RequestCompletion completion;	// of the pending insert or replace, if the request was made with one
 
-	Order(int id, char side, double price, int quantity) : id(id), side(side), price(price), totalQuantity(quantity), remainingQuantity(quantity), filledQuantity(0), orderState(OrderState::NewPending) {}
+	// cold: only read when the market answers, so it is kept after the fields every event touches
+	uint64_t requestTimestamp = 0;	// nowNanos() of the pending insert or replace, 0 when round trips are not measured
+	uint64_t insertTimestamp = 0;	// nowNanos() of the insert request and of the first fill, 0 when lifetimes are not tracked
+	uint64_t firstFillTimestamp = 0;
+	uint32_t replaceCount = 0;	// acknowledged replaces
+	int peakQuantity;	// highest total quantity requested, raised by acknowledged replaces (the total only ever reaches the filled quantity on completion)
+
+	Order(const OrderKey& id, char side, double price, int quantity) : id(id), price(price), totalQuantity(quantity), side(side), remainingQuantity(quantity), filledQuantity(0), orderState(OrderState::NewPending), peakQuantity(quantity) {}
+	const OrderKey& Id() const { return id; }
 	char Side() const { return side; }
 	double Price() const { return price; }
+	int TotalQuantity() const { return totalQuantity; }
 	void ChangeOrderState(bool isPendingOrderUpdate = false);
-	void replaceOrder(int newId, int deltaQuantity);
+	void replaceOrder(const OrderKey& newId, int deltaQuantity);
+};
+
+
+struct AggregateValues
+{
+	int nfq;
+	long double cov[2];	// indexed by side == 'B'
+	long double pov_min[2];
+	long double pov_max[2];
+};
+
+/* Description - All aggregates of both sides in one cache line, as returned by OrderManager::Snapshot().
+	 Trivially copyable, so the publishing, alerting and logging paths can copy it as is.
+*/
+struct alignas(64) AggregateSnapshot
+{
+	int nfq;
+	double cov[2];	// indexed by side == 'B'
+	double pov_min[2];
+	double pov_max[2];
 };
 
+static_assert(sizeof(AggregateSnapshot) == 64, "AggregateSnapshot must fit in one cache line");
+static_assert(std::is_trivially_copyable<AggregateSnapshot>::value, "AggregateSnapshot must be trivially copyable");
 
-class OrderManager : public Listener
+/* Description - Incrementally maintained aggregates of one book: a manager, or one tenant of an OrderManagerHost.
+*/
+struct alignas(64) AggregateState
 {
 	int nfq = 0;
-	long double cov[2] = { 0.0, 0.0 };
-	long double pov_min[2] = { 0.0, 0.0 };
-	long double pov_max[2] = { 0.0, 0.0 };
+	CompensatedSum cov[2];	// indexed by side == 'B'
+	CompensatedSum pov_min[2];
+	CompensatedSum pov_max[2];
 
-	std::unordered_map<int, std::pair<int, int>> replacePendingOrdersMap;
-	std::unordered_map<int, std::shared_ptr<Order>> orders;
+	// Number of orders contributing to COV (confirmed, remaining quantity not 0) and to POV (pending) per side.
+	// When it drops to 0 the aggregate is exactly 0 by definition, so any rounding residue is discarded.
+	int covOrders[2] = { 0, 0 };
+	int povOrders[2] = { 0, 0 };
 
 	void updateNFQ(char side, int quantityFilled);
-	void updateCOV(char side, long double value);
-	void updatePOV(char side, long double minValue, long double maxValue);
+	void updateCOV(char side, double price, long quantity, int contributingOrders);
+	void updatePOV(char side, double price, long minQuantity, long maxQuantity, int contributingOrders);
+	void reset();
+
+	AggregateSnapshot snapshot() const
+	{
+		AggregateSnapshot snapshot;
+		snapshot.nfq = nfq;
+		for (int index = 0; index < 2; ++index)
+		{
+			snapshot.cov[index] = static_cast<double>(cov[index].value());
+			snapshot.pov_min[index] = static_cast<double>(pov_min[index].value());
+			snapshot.pov_max[index] = static_cast<double>(pov_max[index].value());
+		}
+		return snapshot;
+	}
+};
+
+/* Description - 128 bit digest of the complete OrderManager state (orders, pending replaces and aggregates).
+	 Two managers that processed the same events have equal hashes, so a replica or replay can be checked for divergence in O(1).
+*/
+struct StateHash
+{
+	uint64_t low;
+	uint64_t high;
+
+	bool operator==(const StateHash& other) const { return low == other.low && high == other.high; }
+	bool operator!=(const StateHash& other) const { return !(*this == other); }
+};
+
+/* Description - Tracks orders and maintains the aggregates selected by Metrics (see MetricsPolicy.h).
+	 OrderManager maintains all of them; the definitions are in OrderManager.cpp, which instantiates the available policies.
+*/
+template <class Metrics>
+class BasicOrderManager : public Listener, public OrderKeyListener
+{
+	AggregateState aggregates;
+	Metrics metrics;
+
+	// indexed by Order::tenant: only aggregates, unless the manager is the engine of an OrderManagerHost
+	AggregateState* tenantAggregates = &aggregates;
+	uint32_t tenantCount = 1;
+
+	typedef std::pmr::unordered_map<OrderKey, std::pair<OrderKey, int>, OrderKeyHash> PendingReplaceTable;
+	typedef std::pmr::unordered_map<OrderKey, Order*, OrderKeyHash> OrderTable;
+
+	// The orders, the tables and their nodes are all allocated from resource.
+	// When it is a SessionArena, resetSession() abandons them and constructs empty tables in the rewound arena instead of destroying them one by one.
+	std::unique_ptr<SessionArena> ownedArena;
+	std::pmr::memory_resource* resource;
+	SessionArena* arena;	// resource, when it is a SessionArena
+
+	// keyed by the original id, the order keeps it as its key after a replace is acknowledged
+	PendingReplaceTable* replacePendingOrdersMap;
+	OrderTable* orders;
+
+	// capacity reserved by reserve(), applied again to the tables of every new session
+	size_t reservedOrders = 0;
+	size_t reservedPendingReplaces = 0;
+
+	void createSessionTables();
+	void destroySessionTables();
+	Order* allocateOrder(const OrderKey& id, char side, double price, int quantity);
+
+	// Sum (mod 2^64 per lane) of the digests of all orders, including their pending replace.
+	// Order-independent, so every mutation is O(1): subtract the digest before, add it after.
+	// The digest of an order is itself the sum of one digest per group of fields, so an event only rehashes the groups it changes.
+	StateHash orderHash = { 0, 0 };
+	bool stateHashing = Metrics::HASH;
+
+	static const unsigned HashIdentity = 1;	// price and side, fixed from the insert
+	static const unsigned HashQuantities = 2;	// total, remaining and filled quantities and state
+	static const unsigned HashReplace = 4;	// current id and pending replace
+	static const unsigned HashAll = HashIdentity | HashQuantities | HashReplace;
+
+	void hashOrder(const OrderKey& id, const Order& order, unsigned groups, bool add);
+	void rehashOrders();
+
+	// ids of the orders changed since the last checkpoint, each listed once
+	std::pmr::vector<OrderKey> dirtyOrders;
+	bool baseCheckpointRequired = false;	// the session was reset since the last checkpoint, which a delta can not express
+
+	void markDirty(const OrderKey& id, Order& order);
+
+	// replaces the aggregates selected by Metrics with values and recounts the contributing orders, returns the largest correction
+	long double assignAggregates(const AggregateValues& values);
+
+	OrderAuditTrail* auditTrail = nullptr;
+
+	void audit(Order& order, EventType event, int quantity)
+	{
+		if (auditTrail != nullptr)
+			auditTrail->append(order, event, quantity);
+	}
+
+	RoundTripLatency* latency = nullptr;
+
+	void measureRoundTrip(const Order& order, EventType request)
+	{
+		if (latency != nullptr && order.requestTimestamp != 0)
+			latency->record(request, order.Side(), nowNanos() - order.requestTimestamp);
+	}
+
+	OrderLifetimeAnalytics* analytics = nullptr;
+
+	// after the state of order changed: counts it each time it reaches Completed from a state that was not, ignoring the pending
+	// states in between, so a fill or a reduction while a replace is pending does not count it twice nor lose it
+	void trackCompletion(Order& order)
+	{
+		if (order.orderState == OrderState::NewPending || order.orderState == OrderState::ReplacePending)
+			return;
+
+		bool completed = order.orderState == OrderState::Completed;
+		if (analytics != nullptr && completed && !order.completed)
+			analytics->orderCompleted(order, nowNanos());
+		order.completed = completed;
+	}
+
+	friend class OrderSnapshot;
+	friend class OrderManagerHost;
+
+	OrderStatus insertOrder(const OrderKey& id, char side, double price, int quantity, RequestCompletion completion, uint32_t tenant) noexcept;
+
+	void resumeRequest(const OrderKey& id, Order& order, RequestResult result);
+
+	// updates of the aggregates Metrics does not select compile out here
+	static void updateNFQ(AggregateState& book, char side, int quantityFilled)
+	{
+		if constexpr (Metrics::NFQ)
+			book.updateNFQ(side, quantityFilled);
+	}
+
+	static void updateCOV(AggregateState& book, char side, double price, long quantity, int contributingOrders)
+	{
+		if constexpr (Metrics::COV)
+			book.updateCOV(side, price, quantity, contributingOrders);
+	}
+
+	static void updatePOV(AggregateState& book, char side, double price, long minQuantity, long maxQuantity, int contributingOrders)
+	{
+		if constexpr (Metrics::POV)
+			book.updatePOV(side, price, minQuantity, maxQuantity, contributingOrders);
+	}
 
 public:
+	/* Description - Keeps the session state in a SessionArena of its own, over the default resource.
+	*/
+	BasicOrderManager();
+
+	/* Description - Allocates the session state from resource (pool, monotonic buffer, huge pages, ...), which must outlive the manager.
+		 A SessionArena given here must be used by this manager only, since resetSession() resets it.
+	*/
+	explicit BasicOrderManager(std::pmr::memory_resource* resource);
+
+	~BasicOrderManager();
+	BasicOrderManager(const BasicOrderManager&) = delete;
+	BasicOrderManager& operator=(const BasicOrderManager&) = delete;
+
+	/* Description - Records every state transition of every order in trail (nullptr to stop), which must outlive the manager or be detached first.
+		 The trail is reset with the session. Orders created before it was attached only have the history recorded since.
+	*/
+	void setAuditTrail(OrderAuditTrail* trail) { auditTrail = trail; }
+
+	/* Description - Measures the round trip of every insert and replace request, from the request to its acknowledgement or rejection,
+		 into latency (nullptr to stop), which must outlive the manager or be detached first. It is not reset with the session.
+		 Requests made before it was attached are not measured.
+	*/
+	void setLatencyTracker(RoundTripLatency* tracker) { latency = tracker; }
+
+	/* Description - Summarises every order leaving the book into analytics (nullptr to stop), which must outlive the manager or be detached first.
+		 resetSession() summarises the orders still open before dropping them; the analytics themselves are not reset with the session.
+	*/
+	void setLifetimeAnalytics(OrderLifetimeAnalytics* lifetimeAnalytics) { analytics = lifetimeAnalytics; }
+
+	/* Description - The policy instance, holding the state of custom aggregates.
+	*/
+	Metrics& getMetrics() { return metrics; }
+	const Metrics& getMetrics() const { return metrics; }
+
+	/* Description - Starts a new session: drops every order, pending replace and aggregate.
+		 O(1) on a SessionArena, which keeps its memory, so the next session does not page fault or call the system allocator while it warms up;
+		 on other resources the orders and tables are destroyed and deallocated one by one.
+		 The next checkpoint is a base (see requiresBaseCheckpoint()), as the dropped orders are not in the dirty set.
+	*/
+	void resetSession();
+
+	/* Description - Whether the session was reset since the last checkpoint, so that OrderSnapshot::write() writes the next one as a base.
+	*/
+	bool requiresBaseCheckpoint() const { return baseCheckpointRequired; }
+
+	/* Description - Reserves room for the expected number of orders and pending replaces, so the tables do not rehash before reaching it.
+		 The reservation is kept across resetSession().
+	*/
+	void reserve(size_t expectedOrders, size_t expectedPendingReplaces);
+
+	/* Description - Drives synthetic insert, replace, ack, reject and fill traffic through every handler, so code, tables and
+		 session memory are warm for the first real event, then starts a fresh session: nothing of it remains in the aggregates.
+		 An attached audit trail, latency tracker or lifetime analytics is detached meanwhile, so it neither records the synthetic traffic nor is reset.
+		 Meant for startup: returns false and does nothing when the manager already holds orders.
+	*/
+	bool warmUp(int syntheticOrders = 10000);
+
 	/* Description - Indicates the Net Filled Quantity (NFQ) for all orders.
 	*/
-	int getNFQ() { return nfq; }
+	int getNFQ() const { return aggregates.nfq; }
 
 	/* Description - Indicates the Confirmed Order Value (COV) for all orders of given side.
 	     COV = New Acknowledged order + Remaining quantity of partial filled orders
 	*/
-	long double getCOV(char side) { return cov[side == 'B']; }
+	long double getCOV(char side) const { return aggregates.cov[side == 'B'].value(); }
 
 	/* Description - Indicates the Pending Order Value (COV) for all orders of given side.
 		 POV_min = New Acknowledged order + Remaining quantity of partial filled orders
 	*/
-	long double getPOV_min(char side) { return pov_min[side == 'B']; }
-	long double getPOV_max(char side) { return pov_max[side == 'B']; }
+	long double getPOV_min(char side) const { return aggregates.pov_min[side == 'B'].value(); }
+	long double getPOV_max(char side) const { return aggregates.pov_max[side == 'B'].value(); }
+
+	/* Description - Returns every aggregate of both sides at once, rounded to double.
+	*/
+	AggregateSnapshot Snapshot() const { return aggregates.snapshot(); }
+
+	/* Description - Recomputes all aggregates from scratch from the order table, without changing them.
+		 O(number of orders); the incrementally maintained values should match up to rounding.
+	*/
+	AggregateValues recomputeAggregates() const;
+
+	/* Description - Replaces the incrementally maintained aggregates with the values recomputed from the order table.
+		 Returns the largest absolute correction applied, i.e. the drift accumulated since the last reconciliation.
+		 Only the aggregates selected by Metrics are replaced.
+		 O(number of orders), so it is meant to be run periodically from the idle or timer path of the event loop, not per event.
+	*/
+	long double reconcileAggregates();
+
+	/* Description - Same as reconcileAggregates(), with the values recomputed by the SIMD kernel over exportOrderColumns().
+		 Faster on large books; the kernel sums in plain double lanes, so the rebuilt values carry the kernel's rounding.
+	*/
+	long double rebuildAggregates();
+
+	/* Description - Fills columns with the structure-of-arrays view of all orders used by computeAggregates().
+	*/
+	void exportOrderColumns(OrderColumns& columns) const;
+
+	/* Description - Audit check: recomputes all aggregates with the SIMD kernel and compares them with the incremental values.
+		 Returns true when every aggregate selected by Metrics is within tolerance; the recomputed values are stored in recomputed when given.
+	*/
+	bool auditAggregates(long double tolerance, AggregateValues* recomputed = nullptr) const;
+
+	/* Description - Returns the digest of the current state in O(1).
+		 The orders are only covered while state hashing is on (see setStateHashing()), otherwise only the aggregates are.
+	*/
+	StateHash getStateHash() const;
+
+	/* Description - Turns the maintenance of the per-order part of the state hash on or off. It is on by default when Metrics::HASH,
+		 and can not be turned on otherwise. Turning it on rehashes every order, O(orders).
+		 While it is off, the hash can not tell two books with the same aggregates apart, so it must stay on for a primary
+		 whose standbys verify their state (see StandbyReplica::promote()).
+	*/
+	void setStateHashing(bool enabled);
+
+	/* Description - Returns the order tracked by id, or nullptr when it is not present.
+	*/
+	const Order* findOrder(const OrderKey& id) const;
+	const Order* findOrder(int id) const { return findOrder(OrderKey(id)); }
+
+	/* Description - Calls function(const Order&) for every order in slice part of parts disjoint slices of the order table.
+		 Slices only read the table, so they can be visited concurrently (while no events are being processed).
+	*/
+	template <class Function>
+	void forEachOrder(Function function, size_t part = 0, size_t parts = 1) const
+	{
+		size_t buckets = orders->bucket_count();
+		size_t last = buckets * (part + 1) / parts;
+		for (size_t bucket = buckets * part / parts; bucket < last; ++bucket)
+		{
+			for (auto it = orders->begin(bucket); it != orders->end(bucket); ++it)
+				function(static_cast<const Order&>(*it->second));
+		}
+	}
+
+	/* Description - Same as OnInsertOrderRequest / OnReplaceOrderRequest, and completion is resumed inline from
+		 OnRequestAcknowledged or OnRequestRejected once the market answers.
+		 completion is only registered when the status is Ok.
+	   Assumptions -
+		 1. The completion is process-local: it is not part of snapshots or the state hash.
+	*/
+	OrderStatus insertOrder(const OrderKey& id, char side, double price, int quantity, RequestCompletion completion) noexcept { return insertOrder(id, side, price, quantity, completion, 0); }
+	OrderStatus replaceOrder(const OrderKey& oldId, const OrderKey& newId, int deltaQuantity, RequestCompletion completion) noexcept;
+
+	/* Description - Registers completion for the pending insert or replace of id (the old id for a replace), for a request made
+		 through the listeners in front of the manager (JournalWriter, AggregateHistory) rather than with insertOrder / replaceOrder,
+		 which would bypass them. Returns UnknownId, or NotPending when the order has no request pending.
+	*/
+	OrderStatus attachCompletion(const OrderKey& id, RequestCompletion completion) noexcept;
+
+	/* Description - Applies count events in order and stores the status of each in statuses (when not nullptr).
+		 Returns the number of events that were not Ok, so a gateway checks one value per batch and only scans statuses when it is not 0.
+	*/
+	size_t applyEvents(const EventRecord* events, size_t count, OrderStatus* statuses) noexcept;
 
 	/* Description - Indicates the client has sent a new order request to the market.
+		 64-bit and string ids are passed as an OrderKey, see OrderKey.h.
+		 These handlers return the outcome instead of throwing: they are noexcept, and running out of memory terminates.
 	*/
-	virtual void OnInsertOrderRequest(int id, char side, double price, int quantity) override;
+	virtual OrderStatus OnInsertOrderRequest(const OrderKey& id, char side, double price, int quantity) noexcept override final { return insertOrder(id, side, price, quantity, RequestCompletion()); }
 
 	/* Description - Indicates the client has sent a request to change the quantity of an order.
 	   Assumption -
 	     1. deltaQuantity will be positive when increase in quantity
 	     2. deltaQuantity will be negative when decrease in quantity
 	*/
-	virtual void OnReplaceOrderRequest(int oldId, int newId, int deltaQuantity) override;
+	virtual OrderStatus OnReplaceOrderRequest(const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept override final { return replaceOrder(oldId, newId, deltaQuantity, RequestCompletion()); }
 
 	/* Description - Indicates the insert or modify request was accepted.
 	   Assumptions -
 	     1. In case on OnReplaceOrderRequest, id => oldId
 	*/
-	virtual void OnRequestAcknowledged(int id) override;
+	virtual OrderStatus OnRequestAcknowledged(const OrderKey& id) noexcept override final;
 
 	/* Description - Indicates the insert or modify request was rejected.
 	   Assumption -
 	     1. In case of Replace request rejected, the Id is oldId
 	*/
-	virtual void OnRequestRejected(int id) override;
+	virtual OrderStatus OnRequestRejected(const OrderKey& id) noexcept override final;
 
 	/* Description - Indicates that the order quantity was reduced (and filled) by quantityFilled.
 	   Assumtions - 
@@ -86,7 +426,20 @@ public:
 	     2. Allowing Fills more than total quantity (to support additional increased delta quantity of pending replace request) 
 	     3. All fills are recieved as per oldId until pending Replace request is acknowwledged
 	*/
-	virtual void OnOrderFilled(int id, int quantityFilled) override;
+	virtual OrderStatus OnOrderFilled(const OrderKey& id, int quantityFilled) noexcept override final;
+
+	// Listener callbacks with int ids, tracked under the equal integer key
+	virtual void OnInsertOrderRequest(int id, char side, double price, int quantity) override { OnInsertOrderRequest(OrderKey(id), side, price, quantity); }
+	virtual void OnReplaceOrderRequest(int oldId, int newId, int deltaQuantity) override { OnReplaceOrderRequest(OrderKey(oldId), OrderKey(newId), deltaQuantity); }
+	virtual void OnRequestAcknowledged(int id) override { OnRequestAcknowledged(OrderKey(id)); }
+	virtual void OnRequestRejected(int id) override { OnRequestRejected(OrderKey(id)); }
+	virtual void OnOrderFilled(int id, int quantityFilled) override { OnOrderFilled(OrderKey(id), quantityFilled); }
 };
 
+typedef BasicOrderManager<AllMetrics> OrderManager;
+
+// instantiated in OrderManager.cpp
+extern template class BasicOrderManager<AllMetrics>;
+extern template class BasicOrderManager<NFQOnlyMetrics>;
+
 #endif // !ORDERMANAGER_H
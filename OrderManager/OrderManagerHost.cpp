@@ -0,0 +1,125 @@
+#include "OrderManagerHost.h"
+
+#include <cstring>	// for memcpy
+
+using namespace std;
+
+OrderManagerHost::OrderManagerHost(uint32_t tenantCount) : tenants(tenantCount)
+{
+	attachTenants();
+}
+
+OrderManagerHost::OrderManagerHost(uint32_t tenantCount, pmr::memory_resource* resource) : engine(resource), tenants(tenantCount)
+{
+	attachTenants();
+}
+
+void OrderManagerHost::attachTenants()
+{
+	engine.tenantAggregates = tenants.data();
+	engine.tenantCount = static_cast<uint32_t>(tenants.size());
+}
+
+/*
+	Qualified keys never equal an OrderKey made by OrderKey(int64_t) or OrderKey::fromString:
+	  integer id : low = id, high = (tenant + 1) << 8, so high is not 0 and its last byte is 0 in either byte order
+	  string id  : characters 0 to 10, the tenant in bytes 11 to 14 and 0x90 | length in the last byte (0x80 | length for a plain string)
+*/
+bool OrderManagerHost::qualify(uint32_t tenant, const OrderKey& id, OrderKey& key)
+{
+	if (id.isInteger())
+	{
+		key.low = id.low;
+		key.high = (static_cast<uint64_t>(tenant) + 1) << 8;
+		return true;
+	}
+
+	unsigned char bytes[16];
+	memcpy(bytes, &id.low, 8);
+	memcpy(bytes + 8, &id.high, 8);
+	size_t length = bytes[15] & 0x0F;
+	if (length > MaxStringLength)
+		return false;
+
+	memcpy(bytes + MaxStringLength, &tenant, 4);
+	bytes[15] = static_cast<unsigned char>(0x90 | length);
+	memcpy(&key.low, bytes, 8);
+	memcpy(&key.high, bytes + 8, 8);
+	return true;
+}
+
+OrderKey OrderManagerHost::unqualify(const OrderKey& key)
+{
+	unsigned char bytes[16];
+	memcpy(bytes, &key.low, 8);
+	memcpy(bytes + 8, &key.high, 8);
+	if (bytes[15] == 0)
+		return OrderKey(static_cast<int64_t>(key.low));
+
+	OrderKey id;
+	OrderKey::fromString(reinterpret_cast<const char*>(bytes), bytes[15] & 0x0F, id);
+	return id;
+}
+
+const Order* OrderManagerHost::findOrder(uint32_t tenant, const OrderKey& id) const
+{
+	OrderKey key;
+	if (tenant >= tenants.size() || !qualify(tenant, id, key))
+		return nullptr;
+	return engine.findOrder(key);
+}
+
+OrderStatus OrderManagerHost::OnInsertOrderRequest(uint32_t tenant, const OrderKey& id, char side, double price, int quantity) noexcept
+{
+	if (tenant >= tenants.size())
+		return OrderStatus::UnknownTenant;
+
+	OrderKey key;
+	if (!qualify(tenant, id, key))
+		return OrderStatus::InvalidId;
+	return engine.insertOrder(key, side, price, quantity, RequestCompletion(), tenant);
+}
+
+OrderStatus OrderManagerHost::OnReplaceOrderRequest(uint32_t tenant, const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept
+{
+	if (tenant >= tenants.size())
+		return OrderStatus::UnknownTenant;
+
+	OrderKey oldKey, newKey;
+	if (!qualify(tenant, oldId, oldKey) || !qualify(tenant, newId, newKey))
+		return OrderStatus::InvalidId;
+	return engine.OnReplaceOrderRequest(oldKey, newKey, deltaQuantity);
+}
+
+OrderStatus OrderManagerHost::OnRequestAcknowledged(uint32_t tenant, const OrderKey& id) noexcept
+{
+	if (tenant >= tenants.size())
+		return OrderStatus::UnknownTenant;
+
+	OrderKey key;
+	if (!qualify(tenant, id, key))
+		return OrderStatus::InvalidId;
+	return engine.OnRequestAcknowledged(key);
+}
+
+OrderStatus OrderManagerHost::OnRequestRejected(uint32_t tenant, const OrderKey& id) noexcept
+{
+	if (tenant >= tenants.size())
+		return OrderStatus::UnknownTenant;
+
+	OrderKey key;
+	if (!qualify(tenant, id, key))
+		return OrderStatus::InvalidId;
+	return engine.OnRequestRejected(key);
+}
+
+OrderStatus OrderManagerHost::OnOrderFilled(uint32_t tenant, const OrderKey& id, int quantityFilled) noexcept
+{
+	if (tenant >= tenants.size())
+		return OrderStatus::UnknownTenant;
+
+	OrderKey key;
+	if (!qualify(tenant, id, key))
+		return OrderStatus::InvalidId;
+	return engine.OnOrderFilled(key, quantityFilled);
+}
@@ -0,0 +1,79 @@
+#ifndef ORDERMANAGERHOST_H
+#define ORDERMANAGERHOST_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "OrderManager.h"
+
+/* Description - Hosts many logical order managers (tenants, e.g. one per strategy) in one OrderManager.
+	 All tenants share its order slab (session arena) and its one order table, keyed by (tenant, id) packed into 16 bytes,
+	 so an event costs the same table probe as in a dedicated manager, and a tenant costs one AggregateState (two cache lines)
+	 instead of a manager with its own tables, arena and partly empty buckets.
+	 Each tenant keeps its own aggregates, updated incrementally by the handlers like those of a manager.
+   Assumptions -
+	 1. The number of tenants is fixed at construction; tenants are numbered from 0.
+	 2. Ids are per tenant: integer ids, or string ids of up to MaxStringLength characters (the rest of the key holds the tenant).
+	 3. Snapshots, audits and state hashes are per manager and are not offered for a host.
+*/
+class OrderManagerHost
+{
+	OrderManager engine;
+	std::vector<AggregateState> tenants;	// not in the engine's resource, which resetSession() may rewind
+
+	void attachTenants();
+
+public:
+	static const size_t MaxStringLength = 11;
+
+	explicit OrderManagerHost(uint32_t tenantCount);
+
+	/* Description - Allocates the shared orders and table from resource, see OrderManager(std::pmr::memory_resource*).
+	*/
+	OrderManagerHost(uint32_t tenantCount, std::pmr::memory_resource* resource);
+
+	OrderManagerHost(const OrderManagerHost&) = delete;
+	OrderManagerHost& operator=(const OrderManagerHost&) = delete;
+
+	/* Description - Packs id of tenant into the key of the shared order table. Returns false when a string id is longer than MaxStringLength.
+	*/
+	static bool qualify(uint32_t tenant, const OrderKey& id, OrderKey& key);
+
+	/* Description - Returns the id of tenant a qualified key (e.g. Order::Id() of a hosted order) was made from.
+		 Qualified keys are not ids: print or compare the returned id, not the key.
+	*/
+	static OrderKey unqualify(const OrderKey& key);
+
+	uint32_t getTenantCount() const { return static_cast<uint32_t>(tenants.size()); }
+
+	/* Description - Starts a new session for every tenant, see OrderManager::resetSession().
+	*/
+	void resetSession() { engine.resetSession(); }
+
+	/* Description - Reserves room for the expected number of orders and pending replaces of all tenants together.
+	*/
+	void reserve(size_t expectedOrders, size_t expectedPendingReplaces) { engine.reserve(expectedOrders, expectedPendingReplaces); }
+
+	/* Description - Aggregates of tenant, which must be below getTenantCount(). Same definitions as the OrderManager getters.
+	*/
+	int getNFQ(uint32_t tenant) const { return tenants[tenant].nfq; }
+	long double getCOV(uint32_t tenant, char side) const { return tenants[tenant].cov[side == 'B'].value(); }
+	long double getPOV_min(uint32_t tenant, char side) const { return tenants[tenant].pov_min[side == 'B'].value(); }
+	long double getPOV_max(uint32_t tenant, char side) const { return tenants[tenant].pov_max[side == 'B'].value(); }
+	AggregateSnapshot Snapshot(uint32_t tenant) const { return tenants[tenant].snapshot(); }
+
+	/* Description - Returns the order of tenant tracked by id, or nullptr when it is not present. Its Id() is qualified.
+	*/
+	const Order* findOrder(uint32_t tenant, const OrderKey& id) const;
+
+	/* Description - The OrderManager handlers, for the orders of tenant.
+		 They also return UnknownTenant when tenant is not below getTenantCount(), and InvalidId when an id can not be qualified.
+	*/
+	OrderStatus OnInsertOrderRequest(uint32_t tenant, const OrderKey& id, char side, double price, int quantity) noexcept;
+	OrderStatus OnReplaceOrderRequest(uint32_t tenant, const OrderKey& oldId, const OrderKey& newId, int deltaQuantity) noexcept;
+	OrderStatus OnRequestAcknowledged(uint32_t tenant, const OrderKey& id) noexcept;
+	OrderStatus OnRequestRejected(uint32_t tenant, const OrderKey& id) noexcept;
+	OrderStatus OnOrderFilled(uint32_t tenant, const OrderKey& id, int quantityFilled) noexcept;
+};
+
+#endif // !ORDERMANAGERHOST_H
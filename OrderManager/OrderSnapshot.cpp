@@ -0,0 +1,297 @@
+#include "OrderSnapshot.h"
+#include "AggregatePlan.h"
+
+#include <cstdio>	// for remove
+#include <cstdlib>	// for strtoull
+#include <cstring>	// for memcpy
+#include <fstream>
+#include <istream>
+#include <ostream>
+
+using namespace std;
+
+namespace
+{
+	const uint32_t SnapshotMagic = 0x4F4D5331;	// "OMS1"
+	const uint16_t SnapshotVersion = 3;	// 3: per-group order digests, and whether the writer hashed its orders
+	const size_t RecordLength = 74;
+
+	template <class T>
+	void put(ostream& out, T value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <class T>
+	bool get(istream& in, T& value)
+	{
+		return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	template <class T>
+	char* pack(char* p, T value)
+	{
+		memcpy(p, &value, sizeof(T));
+		return p + sizeof(T);
+	}
+
+	template <class T>
+	const char* unpack(const char* p, T& value)
+	{
+		memcpy(&value, p, sizeof(T));
+		return p + sizeof(T);
+	}
+
+	void putSum(ostream& out, const CompensatedSum& sum)
+	{
+		put(out, sum.highPart());
+		put(out, sum.lowPart());
+	}
+
+	bool getSum(istream& in, CompensatedSum& sum)
+	{
+		double high, low;
+		if (!get(in, high) || !get(in, low))
+			return false;
+		sum.assign(high, low);
+		return true;
+	}
+}
+
+template <class Metrics>
+bool OrderSnapshot::write(BasicOrderManager<Metrics>& manager, ostream& out, SnapshotKind kind)
+{
+	if (manager.baseCheckpointRequired)
+		kind = SnapshotKind::Base;
+
+	put(out, SnapshotMagic);
+	put(out, SnapshotVersion);
+	put(out, static_cast<uint8_t>(kind));
+
+	put(out, manager.aggregates.nfq);
+	for (int index = 0; index < 2; ++index)
+	{
+		putSum(out, manager.aggregates.cov[index]);
+		putSum(out, manager.aggregates.pov_min[index]);
+		putSum(out, manager.aggregates.pov_max[index]);
+		put(out, manager.aggregates.covOrders[index]);
+		put(out, manager.aggregates.povOrders[index]);
+	}
+	put(out, static_cast<uint8_t>(manager.stateHashing));
+	put(out, manager.orderHash.low);
+	put(out, manager.orderHash.high);
+
+	uint64_t count = (kind == SnapshotKind::Base) ? manager.orders->size() : manager.dirtyOrders.size();
+	put(out, count);
+
+	auto writeRecord = [&](const OrderKey& key, const Order& order)
+	{
+		OrderKey pendingNewId;
+		int pendingDelta = 0;
+		if (order.orderState == OrderState::ReplacePending)
+		{
+			auto newId_deltaQty = manager.replacePendingOrdersMap->find(key)->second;
+			pendingNewId = newId_deltaQty.first;
+			pendingDelta = newId_deltaQty.second;
+		}
+
+		char record[RecordLength];
+		char* p = pack(record, key);
+		p = pack(p, order.Id());
+		p = pack(p, order.Side());
+		p = pack(p, static_cast<uint8_t>(order.orderState));
+		p = pack(p, order.Price());
+		p = pack(p, static_cast<int32_t>(order.TotalQuantity()));
+		p = pack(p, static_cast<int32_t>(order.remainingQuantity));
+		p = pack(p, static_cast<int32_t>(order.filledQuantity));
+		p = pack(p, pendingNewId);
+		pack(p, static_cast<int32_t>(pendingDelta));
+		out.write(record, RecordLength);
+	};
+
+	if (kind == SnapshotKind::Base)
+	{
+		for (const auto& entry : *manager.orders)
+			writeRecord(entry.first, *entry.second);
+	}
+	else
+	{
+		for (const OrderKey& key : manager.dirtyOrders)
+			writeRecord(key, *manager.orders->find(key)->second);
+	}
+
+	// the checkpoint now covers every change, start tracking afresh
+	for (const OrderKey& key : manager.dirtyOrders)
+		manager.orders->find(key)->second->dirty = false;
+	manager.dirtyOrders.clear();
+	manager.baseCheckpointRequired = false;
+
+	return static_cast<bool>(out);
+}
+
+template <class Metrics>
+bool OrderSnapshot::read(BasicOrderManager<Metrics>& manager, istream& in)
+{
+	uint32_t magic;
+	uint16_t version;
+	uint8_t kind;
+	if (!get(in, magic) || !get(in, version) || !get(in, kind) || magic != SnapshotMagic || version != SnapshotVersion)
+		return false;
+
+	if (static_cast<SnapshotKind>(kind) == SnapshotKind::Base)
+		manager.resetSession();
+
+	bool valid = get(in, manager.aggregates.nfq);
+	for (int index = 0; index < 2; ++index)
+	{
+		valid = valid && getSum(in, manager.aggregates.cov[index]) && getSum(in, manager.aggregates.pov_min[index]) && getSum(in, manager.aggregates.pov_max[index]);
+		valid = valid && get(in, manager.aggregates.covOrders[index]) && get(in, manager.aggregates.povOrders[index]);
+	}
+	uint64_t count;
+	uint8_t hashed;
+	valid = valid && get(in, hashed) && get(in, manager.orderHash.low) && get(in, manager.orderHash.high) && get(in, count);
+	if (!valid)
+		return false;
+
+	if (static_cast<SnapshotKind>(kind) == SnapshotKind::Base)
+		manager.orders->reserve(static_cast<size_t>(count));
+
+	char record[RecordLength];
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		if (!in.read(record, RecordLength))
+			return false;
+
+		OrderKey key, id, pendingNewId;
+		int32_t total, remaining, filled, pendingDelta;
+		char side;
+		uint8_t state;
+		double price;
+		const char* p = unpack(record, key);
+		p = unpack(p, id);
+		p = unpack(p, side);
+		p = unpack(p, state);
+		p = unpack(p, price);
+		p = unpack(p, total);
+		p = unpack(p, remaining);
+		p = unpack(p, filled);
+		p = unpack(p, pendingNewId);
+		unpack(p, pendingDelta);
+
+		// a changed order is overwritten in place, only new ones take arena memory
+		Order*& orderPtr = (*manager.orders)[key];
+		if (orderPtr == nullptr)
+			orderPtr = manager.allocateOrder(id, side, price, total);
+		else
+		{
+			manager.metrics.beforeChange(*orderPtr);
+			*orderPtr = Order(id, side, price, total);
+		}
+		orderPtr->remainingQuantity = remaining;
+		orderPtr->filledQuantity = filled;
+		orderPtr->orderState = static_cast<OrderState>(state);
+		orderPtr->completed = orderPtr->orderState == OrderState::Completed;
+		manager.metrics.afterChange(*orderPtr);
+
+		if (orderPtr->orderState == OrderState::ReplacePending)
+			(*manager.replacePendingOrdersMap)[key] = make_pair(pendingNewId, pendingDelta);
+		else
+			manager.replacePendingOrdersMap->erase(key);
+	}
+
+	// the restored state is the checkpoint's, reset or not
+	if (static_cast<SnapshotKind>(kind) == SnapshotKind::Base)
+		manager.baseCheckpointRequired = false;
+
+	// a writer that did not hash its orders stored only 0: the reader hashes them itself, or keeps 0 when it does not hash either
+	if (!manager.stateHashing)
+		manager.orderHash = { 0, 0 };
+	else if (!hashed)
+		manager.rehashOrders();
+	return true;
+}
+
+bool CheckpointChain::writeManifest() const
+{
+	ofstream manifest(directory + "/chain.txt", ios::trunc);
+	for (const string& file : files)
+		manifest << file << '\n';
+	return static_cast<bool>(manifest);
+}
+
+template <class Metrics>
+bool CheckpointChain::checkpoint(BasicOrderManager<Metrics>& manager)
+{
+	bool base = files.empty() || checkpointNumber % baseInterval == 0 || manager.requiresBaseCheckpoint();
+	string name = "checkpoint-" + to_string(checkpointNumber) + (base ? ".base" : ".delta");
+
+	ofstream out(directory + "/" + name, ios::binary | ios::trunc);
+	if (!out || !OrderSnapshot::write(manager, out, base ? SnapshotKind::Base : SnapshotKind::Delta))
+		return false;
+	out.close();
+	if (!out)
+		return false;
+
+	// a new base makes the previous chain redundant
+	vector<string> previous;
+	if (base)
+		previous.swap(files);
+	files.push_back(name);
+	++checkpointNumber;
+
+	if (!writeManifest())
+		return false;
+	for (const string& file : previous)
+		remove((directory + "/" + file).c_str());
+	return true;
+}
+
+template <class Metrics>
+bool CheckpointChain::restore(BasicOrderManager<Metrics>& manager)
+{
+	ifstream manifest(directory + "/chain.txt");
+	if (!manifest)
+		return false;
+
+	vector<string> chain;
+	string file;
+	while (getline(manifest, file))
+	{
+		if (!file.empty())
+			chain.push_back(file);
+	}
+	if (chain.empty())
+		return false;
+
+	for (const string& name : chain)
+	{
+		ifstream in(directory + "/" + name, ios::binary);
+		if (!in || !OrderSnapshot::read(manager, in))
+			return false;
+	}
+
+	// continue the chain after the restored checkpoints
+	files = chain;
+	checkpointNumber = 0;
+	for (const string& name : chain)
+	{
+		uint64_t number = strtoull(name.c_str() + sizeof("checkpoint-") - 1, nullptr, 10);
+		if (number + 1 > checkpointNumber)
+			checkpointNumber = number + 1;
+	}
+	return true;
+}
+
+// the policies instantiated in OrderManager.cpp
+template bool OrderSnapshot::write(BasicOrderManager<AllMetrics>&, ostream&, SnapshotKind);
+template bool OrderSnapshot::write(BasicOrderManager<NFQOnlyMetrics>&, ostream&, SnapshotKind);
+template bool OrderSnapshot::write(BasicOrderManager<PlannedMetrics>&, ostream&, SnapshotKind);
+template bool OrderSnapshot::read(BasicOrderManager<AllMetrics>&, istream&);
+template bool OrderSnapshot::read(BasicOrderManager<NFQOnlyMetrics>&, istream&);
+template bool OrderSnapshot::read(BasicOrderManager<PlannedMetrics>&, istream&);
+template bool CheckpointChain::checkpoint(BasicOrderManager<AllMetrics>&);
+template bool CheckpointChain::checkpoint(BasicOrderManager<NFQOnlyMetrics>&);
+template bool CheckpointChain::checkpoint(BasicOrderManager<PlannedMetrics>&);
+template bool CheckpointChain::restore(BasicOrderManager<AllMetrics>&);
+template bool CheckpointChain::restore(BasicOrderManager<NFQOnlyMetrics>&);
+template bool CheckpointChain::restore(BasicOrderManager<PlannedMetrics>&);
@@ -0,0 +1,66 @@
+#ifndef ORDERSNAPSHOT_H
+#define ORDERSNAPSHOT_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "OrderManager.h"
+
+enum class SnapshotKind : uint8_t { Base, Delta };
+
+/* Description - Binary checkpoints of an OrderManager.
+	 A base snapshot holds every order; a delta holds only the orders changed since the previous checkpoint (base or delta).
+	 Both hold the aggregates, the contributing order counts and the state hash, which are a few dozen bytes,
+	 so a delta costs I/O proportional to the activity since the last checkpoint rather than to the size of the book.
+	 Pending replaces are stored with their order.
+	 A delta can not express the orders dropped by resetSession(), so the first checkpoint after a reset is always a base.
+	 Any metrics policy is accepted: the aggregates it does not select are stored as 0, and its custom aggregates are not
+	 stored but rebuilt by read() through the policy's beforeChange / afterChange hooks.
+	 Instantiated in OrderSnapshot.cpp for the policies of OrderManager.cpp.
+*/
+class OrderSnapshot
+{
+public:
+	/* Description - Writes a checkpoint of manager to out and clears its dirty set. Returns false on a write error.
+		 A delta is written as a base when manager.requiresBaseCheckpoint().
+	*/
+	template <class Metrics>
+	static bool write(BasicOrderManager<Metrics>& manager, std::ostream& out, SnapshotKind kind);
+
+	/* Description - Applies a checkpoint to manager: a base replaces the whole state, a delta is applied on top of it.
+		 Returns false when the data is not a snapshot or is truncated; manager is then only partially restored.
+	*/
+	template <class Metrics>
+	static bool read(BasicOrderManager<Metrics>& manager, std::istream& in);
+};
+
+/* Description - Chain of checkpoint files in a directory: a base followed by deltas.
+	 Every baseInterval checkpoints, and after each resetSession() of the manager, a new base is written and the previous chain
+	 is deleted, which bounds restore time.
+	 The chain is listed in order in <directory>/chain.txt so that a fresh process can restore it.
+*/
+class CheckpointChain
+{
+	std::string directory;
+	unsigned baseInterval;
+	uint64_t checkpointNumber = 0;
+	std::vector<std::string> files;	// base first
+
+	bool writeManifest() const;
+
+public:
+	CheckpointChain(const std::string& directory, unsigned baseInterval) : directory(directory), baseInterval(baseInterval == 0 ? 1 : baseInterval) {}
+
+	/* Description - Writes the next checkpoint of manager (base or delta). Returns false on an I/O error.
+	*/
+	template <class Metrics>
+	bool checkpoint(BasicOrderManager<Metrics>& manager);
+
+	/* Description - Restores manager from the chain listed in the directory. Returns false when it is missing or damaged.
+	*/
+	template <class Metrics>
+	bool restore(BasicOrderManager<Metrics>& manager);
+};
+
+#endif // !ORDERSNAPSHOT_H
@@ -0,0 +1,162 @@
+#include "QueryServer.h"
+
+#include <new>	// for placement new
+
+using namespace std;
+
+bool QueryServer::create(const string& name)
+{
+	if (!memory.create(name, sizeof(QueryChannel)))
+		return false;
+
+	// the region is zero filled, so every slot starts as QuerySlotFree
+	channel = new (memory.data()) QueryChannel;
+	channel->slotCount = QuerySlotCount;
+	channel->sequence.store(0, memory_order_relaxed);
+	channel->pendingRequests.store(0, memory_order_relaxed);
+	publish();
+
+	atomic_thread_fence(memory_order_release);
+	channel->magic = QueryChannelMagic;
+	return true;
+}
+
+void QueryServer::publish()
+{
+	if (channel == nullptr)
+		return;
+
+	uint64_t sequence = channel->sequence.load(memory_order_relaxed);
+	channel->sequence.store(sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	AggregateSnapshot snapshot = manager.Snapshot();
+	channel->nfq.store(snapshot.nfq, memory_order_relaxed);
+	for (int i = 0; i < 2; ++i)
+	{
+		channel->cov[i].store(snapshot.cov[i], memory_order_relaxed);
+		channel->pov_min[i].store(snapshot.pov_min[i], memory_order_relaxed);
+		channel->pov_max[i].store(snapshot.pov_max[i], memory_order_relaxed);
+	}
+
+	channel->sequence.store(sequence + 2, memory_order_release);
+}
+
+size_t QueryServer::poll()
+{
+	if (channel == nullptr || channel->pendingRequests.load(memory_order_acquire) == 0)
+		return 0;
+
+	size_t answered = 0;
+	for (QuerySlot& slot : channel->slots)
+	{
+		uint32_t expected = QuerySlotRequested;
+		if (slot.state.load(memory_order_relaxed) != QuerySlotRequested || !slot.state.compare_exchange_strong(expected, QuerySlotServing, memory_order_acquire))
+			continue;
+
+		OrderQueryResult& result = slot.result;
+		const Order* order = manager.findOrder(slot.orderId);
+		result.found = order != nullptr;
+		if (order != nullptr)
+		{
+			result.side = order->Side();
+			result.price = order->Price();
+			result.totalQuantity = order->TotalQuantity();
+			result.remainingQuantity = order->remainingQuantity;
+			result.filledQuantity = order->filledQuantity;
+			result.orderState = order->orderState;
+		}
+
+		slot.state.store(QuerySlotAnswered, memory_order_release);
+		channel->pendingRequests.fetch_sub(1, memory_order_relaxed);
+		++answered;
+	}
+	return answered;
+}
+
+bool QueryClient::open(const string& name)
+{
+	if (!memory.open(name, sizeof(QueryChannel)))
+		return false;
+
+	channel = static_cast<QueryChannel*>(memory.data());
+	atomic_thread_fence(memory_order_acquire);
+	if (channel->magic != QueryChannelMagic || channel->slotCount != QuerySlotCount)
+	{
+		channel = nullptr;
+		return false;
+	}
+	return true;
+}
+
+bool QueryClient::readAggregates(AggregateQueryResult& result, uint64_t maxSpins) const
+{
+	for (uint64_t spin = 0; spin < maxSpins; ++spin)
+	{
+		uint64_t before = channel->sequence.load(memory_order_acquire);
+
+		result.nfq = channel->nfq.load(memory_order_relaxed);
+		for (int i = 0; i < 2; ++i)
+		{
+			result.cov[i] = channel->cov[i].load(memory_order_relaxed);
+			result.pov_min[i] = channel->pov_min[i].load(memory_order_relaxed);
+			result.pov_max[i] = channel->pov_max[i].load(memory_order_relaxed);
+		}
+
+		atomic_thread_fence(memory_order_acquire);
+		uint64_t after = channel->sequence.load(memory_order_relaxed);
+		if (!(before & 1) && before == after)
+		{
+			result.version = before / 2;
+			return true;
+		}
+		// a publish was in progress: retry
+	}
+	return false;
+}
+
+bool QueryClient::lookupOrder(const OrderKey& id, OrderQueryResult& result, uint64_t maxSpins)
+{
+	for (QuerySlot& slot : channel->slots)
+	{
+		uint32_t expected = QuerySlotFree;
+		if (!slot.state.compare_exchange_strong(expected, QuerySlotClaimed, memory_order_acquire))
+			continue;
+
+		// counted before it becomes visible, so the server never decrements below zero
+		slot.orderId = id;
+		channel->pendingRequests.fetch_add(1, memory_order_relaxed);
+		slot.state.store(QuerySlotRequested, memory_order_release);
+
+		for (uint64_t spin = 0; spin < maxSpins; ++spin)
+		{
+			if (slot.state.load(memory_order_acquire) == QuerySlotAnswered)
+			{
+				result = slot.result;
+				slot.state.store(QuerySlotFree, memory_order_release);
+				return true;
+			}
+		}
+
+		// timed out: take the request back unless the server is answering it right now
+		expected = QuerySlotRequested;
+		if (slot.state.compare_exchange_strong(expected, QuerySlotClaimed, memory_order_acquire))
+		{
+			channel->pendingRequests.fetch_sub(1, memory_order_relaxed);
+			slot.state.store(QuerySlotFree, memory_order_release);
+			return false;
+		}
+		// the server is serving it: wait once more, and if it still does not answer it stopped mid-request
+		for (uint64_t spin = 0; spin < maxSpins; ++spin)
+		{
+			if (slot.state.load(memory_order_acquire) == QuerySlotAnswered)
+			{
+				result = slot.result;
+				slot.state.store(QuerySlotFree, memory_order_release);
+				return true;
+			}
+		}
+		return false;	// the slot is lost: it is not freed, so a late answer never lands in a slot reused by another request
+	}
+	return false;
+}
@@ -0,0 +1,112 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "OrderManager.h"
+#include "SharedMemory.h"
+
+/* Description - Layout of the shared-memory query channel between a running OrderManager and other processes.
+	 Aggregates are published under a sequence lock, so readers never wait for the event thread and the event thread never waits for readers.
+	 Order lookups go through a fixed array of request/response slots, each owned by one side at a time through its state.
+*/
+const uint32_t QueryChannelMagic = 0x4F4D5132;	// "OMQ2"
+const size_t QuerySlotCount = 64;
+
+enum QuerySlotState : uint32_t { QuerySlotFree, QuerySlotClaimed, QuerySlotRequested, QuerySlotServing, QuerySlotAnswered };
+
+struct OrderQueryResult
+{
+	bool found;
+	char side;
+	double price;
+	int totalQuantity;
+	int remainingQuantity;
+	int filledQuantity;
+	OrderState orderState;
+};
+
+struct AggregateQueryResult
+{
+	uint64_t version;	// number of publishes so far
+	int nfq;
+	double cov[2];	// indexed by side == 'B'
+	double pov_min[2];
+	double pov_max[2];
+};
+
+struct alignas(64) QuerySlot
+{
+	std::atomic<uint32_t> state;
+	OrderKey orderId;
+	OrderQueryResult result;
+};
+
+struct QueryChannel
+{
+	uint32_t magic;
+	uint32_t slotCount;
+
+	alignas(64) std::atomic<uint64_t> sequence;	// odd while the aggregates are being written
+	std::atomic<int> nfq;
+	std::atomic<double> cov[2];
+	std::atomic<double> pov_min[2];
+	std::atomic<double> pov_max[2];
+
+	alignas(64) std::atomic<uint32_t> pendingRequests;	// lets poll() skip the slot scan when idle
+	QuerySlot slots[QuerySlotCount];
+};
+
+/* Description - Serves aggregate and order queries of an OrderManager over shared memory.
+	 Everything runs on the event thread: publish() after each event (or batch), poll() whenever the loop is idle or between events.
+	 Neither call blocks or takes a lock.
+*/
+class QueryServer
+{
+	const OrderManager& manager;
+	SharedMemory memory;
+	QueryChannel* channel = nullptr;
+
+public:
+	explicit QueryServer(const OrderManager& manager) : manager(manager) {}
+
+	/* Description - Creates the named channel, returns false when the shared memory can not be created.
+	*/
+	bool create(const std::string& name);
+
+	/* Description - Publishes the current aggregates to readers.
+	*/
+	void publish();
+
+	/* Description - Answers the pending order lookups, returns the number answered.
+	*/
+	size_t poll();
+};
+
+/* Description - Query side of the channel, used by other processes (risk GUI, hedger).
+*/
+class QueryClient
+{
+	SharedMemory memory;
+	QueryChannel* channel = nullptr;
+
+public:
+	/* Description - Opens the channel created by a QueryServer, returns false when it does not exist.
+	*/
+	bool open(const std::string& name);
+
+	/* Description - Reads a consistent copy of the last published aggregates into result without blocking the server.
+		 Returns false when no consistent copy was read within maxSpins attempts, e.g. the server stopped in the middle of a publish.
+	*/
+	bool readAggregates(AggregateQueryResult& result, uint64_t maxSpins = 100000000) const;
+
+	/* Description - Looks up an order through the server.
+		 Returns false when no slot is free or the server did not answer within maxSpins polls of the slot.
+		 A request the server started serving is waited for another maxSpins polls; past that the server is considered stopped
+		 and the slot is left claimed (lost) until the channel is recreated.
+	*/
+	bool lookupOrder(const OrderKey& id, OrderQueryResult& result, uint64_t maxSpins = 100000000);
+};
+
+#endif // !QUERYSERVER_H
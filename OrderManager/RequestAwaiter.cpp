@@ -0,0 +1,54 @@
+#include "RequestAwaiter.h"
+
+#include <new>
+
+using namespace std;
+
+namespace
+{
+	const size_t FrameGranule = 64;
+	const size_t FrameSizeClasses = 16;	// frames up to 1 KB are pooled
+
+	struct FreeFrame
+	{
+		FreeFrame* next;
+	};
+
+	thread_local FreeFrame* freeFrames[FrameSizeClasses] = {};
+}
+
+void* CoroutineFramePool::allocate(size_t size)
+{
+	size_t sizeClass = (size - 1) / FrameGranule;
+	if (sizeClass >= FrameSizeClasses)	// including size 0, which wraps around
+		return ::operator new(size);
+
+	FreeFrame* frame = freeFrames[sizeClass];
+	if (frame == nullptr)
+		return ::operator new((sizeClass + 1) * FrameGranule);
+	freeFrames[sizeClass] = frame->next;
+	return frame;
+}
+
+void CoroutineFramePool::deallocate(void* frame, size_t size) noexcept
+{
+	size_t sizeClass = (size - 1) / FrameGranule;
+	if (sizeClass >= FrameSizeClasses)
+	{
+		::operator delete(frame);
+		return;
+	}
+
+	FreeFrame* freed = static_cast<FreeFrame*>(frame);
+	freed->next = freeFrames[sizeClass];
+	freeFrames[sizeClass] = freed;
+}
+
+void CoroutineFramePool::reserve(size_t frameSize, size_t count)
+{
+	if (frameSize == 0 || (frameSize - 1) / FrameGranule >= FrameSizeClasses)
+		return;
+
+	for (size_t i = 0; i < count; ++i)
+		deallocate(::operator new(((frameSize - 1) / FrameGranule + 1) * FrameGranule), frameSize);
+}
@@ -0,0 +1,166 @@
+#ifndef REQUESTAWAITER_H
+#define REQUESTAWAITER_H
+
+/* Coroutine layer over RequestCompletion, available when the compiler supports coroutines:
+   C++20 (__cpp_impl_coroutine), or VS2017 and later with /await (_RESUMABLE_FUNCTIONS_SUPPORTED, <experimental/coroutine>).
+   The project enables /await; other builds simply do not get these types. */
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define ORDERMANAGER_COROUTINES 1
+template <class Promise = void>
+using CoroutineHandle = std::coroutine_handle<Promise>;
+using SuspendNever = std::suspend_never;
+#elif defined(_RESUMABLE_FUNCTIONS_SUPPORTED)
+#include <experimental/coroutine>
+#define ORDERMANAGER_COROUTINES 1
+template <class Promise = void>
+using CoroutineHandle = std::experimental::coroutine_handle<Promise>;
+using SuspendNever = std::experimental::suspend_never;
+#endif
+
+#include <cstddef>
+#include <exception>	// for terminate
+#include "OrderKey.h"
+#include "OrderKeyListener.h"
+#include "RequestCompletion.h"
+
+/* Description - Allocator of coroutine frames: one free list per 64 byte size class, up to 1 KB, per thread.
+	 A freed frame is kept for the next frame of its class, so once the strategies' frames have been allocated
+	 (or reserved at startup) starting a coroutine does not reach the heap.
+   Assumptions -
+	 1. Pooled frames are never returned to the heap; larger frames go to operator new / delete.
+	 2. A frame is freed on the thread that allocated it (the event loop thread).
+*/
+class CoroutineFramePool
+{
+public:
+	static void* allocate(size_t size);
+	static void deallocate(void* frame, size_t size) noexcept;
+
+	/* Description - Preallocates count frames of frameSize bytes, e.g. from the warm-up path.
+	*/
+	static void reserve(size_t frameSize, size_t count);
+};
+
+#if defined(ORDERMANAGER_COROUTINES)
+
+/* Description - Outcome of a co_await-ed request: status is the outcome of the request itself,
+	 and result the market's answer, only meaningful when status is Ok.
+*/
+struct RequestOutcome
+{
+	OrderStatus status;
+	RequestResult result;
+};
+
+/* Description - Awaitable insert or replace request on a BasicOrderManager, see insertRequest() and replaceRequest().
+	 await_suspend makes the request through entry, the first listener of the event path (the manager itself, or a JournalWriter
+	 or AggregateHistory in front of it), so the request is journaled and recorded like any other event, then registers a
+	 RequestCompletion holding resumeAwaiter and the address of the awaiter, which lives in the coroutine frame, with the manager
+	 (BasicOrderManager::attachCompletion()); the manager resumes the coroutine inline from OnRequestAcknowledged or OnRequestRejected.
+	 A request the event path refuses (status other than Ok) does not suspend.
+   Assumptions -
+	 1. The coroutine runs inside the acknowledgement or rejection handler, so it must not block; it may make the next request.
+	 2. A request that is never answered (e.g. dropped by resetSession()) leaves its coroutine suspended: the owner destroys it.
+	 3. When a journal or history is in front of the manager, requests must be made with the overloads taking entry:
+	    the ones taking only the manager bypass them, and the replicas and the history would miss the request.
+*/
+template <class Manager>
+class OrderRequestAwaiter
+{
+	OrderKeyListener& entry;
+	Manager& manager;
+	bool replace;
+	OrderKey id;
+	OrderKey newId;
+	char side;
+	double price;
+	int quantity;	// deltaQuantity for a replace
+
+	OrderStatus status = OrderStatus::Ok;
+	RequestResult result = RequestResult::Rejected;
+	CoroutineHandle<> continuation;
+
+	static void resumeAwaiter(void* context, const OrderKey&, RequestResult result)
+	{
+		OrderRequestAwaiter* awaiter = static_cast<OrderRequestAwaiter*>(context);
+		awaiter->result = result;
+		awaiter->continuation.resume();
+	}
+
+public:
+	OrderRequestAwaiter(OrderKeyListener& entry, Manager& manager, bool replace, const OrderKey& id, const OrderKey& newId, char side, double price, int quantity)
+		: entry(entry), manager(manager), replace(replace), id(id), newId(newId), side(side), price(price), quantity(quantity) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	bool await_suspend(CoroutineHandle<> handle) noexcept
+	{
+		continuation = handle;
+		RequestCompletion completion;
+		completion.resume = &resumeAwaiter;
+		completion.context = this;
+		if (&entry == static_cast<OrderKeyListener*>(&manager))
+			status = replace ? manager.replaceOrder(id, newId, quantity, completion) : manager.insertOrder(id, side, price, quantity, completion);
+		else
+		{
+			status = replace ? entry.OnReplaceOrderRequest(id, newId, quantity) : entry.OnInsertOrderRequest(id, side, price, quantity);
+			if (status == OrderStatus::Ok)
+				status = manager.attachCompletion(id, completion);
+		}
+		return status == OrderStatus::Ok;
+	}
+
+	RequestOutcome await_resume() const noexcept { return { status, result }; }
+};
+
+// co_await insertRequest(manager, id, side, price, quantity) -> RequestOutcome, when nothing is in front of manager
+template <class Manager>
+OrderRequestAwaiter<Manager> insertRequest(Manager& manager, const OrderKey& id, char side, double price, int quantity)
+{
+	return OrderRequestAwaiter<Manager>(manager, manager, false, id, OrderKey(), side, price, quantity);
+}
+
+// co_await insertRequest(journal, manager, id, side, price, quantity) -> RequestOutcome, through entry in front of manager
+template <class Manager>
+OrderRequestAwaiter<Manager> insertRequest(OrderKeyListener& entry, Manager& manager, const OrderKey& id, char side, double price, int quantity)
+{
+	return OrderRequestAwaiter<Manager>(entry, manager, false, id, OrderKey(), side, price, quantity);
+}
+
+// co_await replaceRequest(manager, oldId, newId, deltaQuantity) -> RequestOutcome, when nothing is in front of manager
+template <class Manager>
+OrderRequestAwaiter<Manager> replaceRequest(Manager& manager, const OrderKey& oldId, const OrderKey& newId, int deltaQuantity)
+{
+	return OrderRequestAwaiter<Manager>(manager, manager, true, oldId, newId, '\0', 0.0, deltaQuantity);
+}
+
+// co_await replaceRequest(journal, manager, oldId, newId, deltaQuantity) -> RequestOutcome, through entry in front of manager
+template <class Manager>
+OrderRequestAwaiter<Manager> replaceRequest(OrderKeyListener& entry, Manager& manager, const OrderKey& oldId, const OrderKey& newId, int deltaQuantity)
+{
+	return OrderRequestAwaiter<Manager>(entry, manager, true, oldId, newId, '\0', 0.0, deltaQuantity);
+}
+
+/* Description - Return type of a fire-and-forget strategy coroutine: it starts at once, runs until its first co_await,
+	 and its frame (allocated from CoroutineFramePool) is freed when it returns.
+	 e.g. OrderTask work(OrderManager& manager) { RequestOutcome outcome = co_await insertRequest(manager, id, 'B', 10.0, 5); ... }
+*/
+struct OrderTask
+{
+	struct promise_type
+	{
+		OrderTask get_return_object() noexcept { return OrderTask(); }
+		SuspendNever initial_suspend() const noexcept { return {}; }
+		SuspendNever final_suspend() const noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+
+		static void* operator new(size_t size) { return CoroutineFramePool::allocate(size); }
+		static void operator delete(void* frame, size_t size) noexcept { CoroutineFramePool::deallocate(frame, size); }
+	};
+};
+
+#endif // ORDERMANAGER_COROUTINES
+
+#endif // !REQUESTAWAITER_H
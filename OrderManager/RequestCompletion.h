@@ -0,0 +1,29 @@
+#ifndef REQUESTCOMPLETION_H
+#define REQUESTCOMPLETION_H
+
+#include "OrderKey.h"
+
+enum class RequestResult { Acknowledged, Rejected };
+
+/* Description - Continuation of an insert or replace request, resumed inline by the manager when the market acknowledges or rejects it.
+	 A plain function pointer and context, so it is stored in the order record and registering or resuming it never allocates.
+	 id is the id the request was made with (oldId for a replace).
+*/
+struct RequestCompletion
+{
+	void (*resume)(void* context, const OrderKey& id, RequestResult result) = nullptr;
+	void* context = nullptr;
+};
+
+/* Description - Completion calling object->Method(id, result), e.g. completionFor<Strategy, &Strategy::onInsertDone>(this).
+*/
+template <class T, void (T::*Method)(const OrderKey&, RequestResult)>
+RequestCompletion completionFor(T* object)
+{
+	RequestCompletion completion;
+	completion.resume = [](void* context, const OrderKey& id, RequestResult result) { (static_cast<T*>(context)->*Method)(id, result); };
+	completion.context = object;
+	return completion;
+}
+
+#endif // !REQUESTCOMPLETION_H
@@ -0,0 +1,942 @@
+#include "SelfTest.h"
+
+#include <cstdio>
+#include <cstring>	// for memcpy
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <utility>	// for declval
+#include <vector>
+#include "AggregateHistory.h"
+#include "AggregatePlan.h"
+#include "Clock.h"
+#include "CompensatedSum.h"
+#include "EndOfDayReconciler.h"
+#include "EventFileLoader.h"
+#include "EventJournal.h"
+#include "EventRecord.h"
+#include "FixParser.h"
+#include "HugePageResource.h"
+#include "LatencyHistogram.h"
+#include "OrderManagerHost.h"
+#include "OrderSnapshot.h"
+#include "QueryServer.h"
+#include "RequestAwaiter.h"
+#include "StandbyReplica.h"
+#include "WireProtocol.h"
+
+using namespace std;
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "self-test failed: %s\n", what);
+			++failures;
+		}
+	}
+
+	// records the decoded callbacks, one EventRecord each
+	struct RecordingListener : Listener
+	{
+		vector<EventRecord> events;
+
+		void OnInsertOrderRequest(int id, char side, double price, int quantity) override { events.push_back({ EventType::Insert, side, OrderKey(id), price, quantity, OrderKey(), 0 }); }
+		void OnReplaceOrderRequest(int oldId, int newId, int deltaQuantity) override { events.push_back({ EventType::Replace, 0, OrderKey(oldId), 0.0, 0, OrderKey(newId), deltaQuantity }); }
+		void OnRequestAcknowledged(int id) override { events.push_back({ EventType::Acknowledge, 0, OrderKey(id), 0.0, 0, OrderKey(), 0 }); }
+		void OnRequestRejected(int id) override { events.push_back({ EventType::Reject, 0, OrderKey(id), 0.0, 0, OrderKey(), 0 }); }
+		void OnOrderFilled(int id, int quantityFilled) override { events.push_back({ EventType::Fill, 0, OrderKey(id), 0.0, quantityFilled, OrderKey(), 0 }); }
+	};
+
+	void testWireProtocol()
+	{
+		char buffer[512];
+		size_t length = 0;
+		length += encodeWireInsert(buffer + length, 1, 'B', 100.5, 30);
+		length += encodeWireReplace(buffer + length, 1, 2, -10);
+		length += encodeWireAck(buffer + length, 2);
+		length += encodeWireReject(buffer + length, 3);
+		length += encodeWireFill(buffer + length, 2, 5);
+
+		RecordingListener decoded;
+		size_t rejected = 0;
+		check(decodeWireMessages(decoded, buffer, length, &rejected) == length && rejected == 0, "wire: whole batch decoded");
+		check(decoded.events.size() == 5, "wire: one callback per message");
+		if (decoded.events.size() == 5)
+		{
+			const EventRecord* e = decoded.events.data();
+			check(e[0].type == EventType::Insert && e[0].id == OrderKey(1) && e[0].side == 'B' && e[0].price == 100.5 && e[0].quantity == 30, "wire: insert round trip");
+			check(e[1].type == EventType::Replace && e[1].id == OrderKey(1) && e[1].newId == OrderKey(2) && e[1].deltaQuantity == -10, "wire: replace round trip");
+			check(e[2].type == EventType::Acknowledge && e[2].id == OrderKey(2), "wire: ack round trip");
+			check(e[3].type == EventType::Reject && e[3].id == OrderKey(3), "wire: reject round trip");
+			check(e[4].type == EventType::Fill && e[4].id == OrderKey(2) && e[4].quantity == 5, "wire: fill round trip");
+		}
+
+		// a partial message is left for the next receive
+		RecordingListener partial;
+		size_t first = WireHeaderLength + WireInsertBlockLength;
+		check(decodeWireMessages(partial, buffer, first + 3) == first && partial.events.size() == 1, "wire: partial message left");
+
+		// an insert whose blockLength does not cover its fields, another schema and an older version are skipped
+		char malformed[256];
+		encodeWireInsert(malformed, 7, 'S', 99.0, 10);
+		uint16_t shortLength = 4;
+		memcpy(malformed, &shortLength, 2);
+		size_t malformedLength = WireHeaderLength + shortLength;
+		malformedLength += encodeWireFill(malformed + malformedLength, 8, 1);
+		memset(malformed + malformedLength - WireFillBlockLength - 4, 0x7F, 2);	// schemaId
+		size_t versionOffset = malformedLength;
+		malformedLength += encodeWireAck(malformed + malformedLength, 9);
+		memset(malformed + versionOffset + 6, 0, 2);	// version 0
+		malformedLength += encodeWireAck(malformed + malformedLength, 10);
+
+		RecordingListener skipped;
+		rejected = 0;
+		check(decodeWireMessages(skipped, malformed, malformedLength, &rejected) == malformedLength && rejected == 3, "wire: malformed messages rejected");
+		check(skipped.events.size() == 1 && skipped.events[0].id == OrderKey(10), "wire: decoding resumes after malformed messages");
+	}
+
+	// FIX messages written with '|' for SOH
+	string fixMessages(const char* text)
+	{
+		string messages(text);
+		for (char& c : messages)
+		{
+			if (c == '|')
+				c = '\x01';
+		}
+		return messages;
+	}
+
+	void testFixParser()
+	{
+		OrderManager manager;
+		FixParser parser(manager);
+		string messages = fixMessages(
+			"8=FIX.4.4|35=D|11=A1|54=1|44=100.25|38=10|10=000|"
+			"8=FIX.4.4|35=8|150=0|11=A1|10=000|"
+			"8=FIX.4.4|35=G|11=A2|41=A1|38=15|10=000|"
+			"8=FIX.4.4|35=8|150=5|11=A2|41=A1|10=000|"
+			"8=FIX.4.4|35=8|150=1|11=A2|32=5|10=000|"
+			"8=FIX.4.4|35=G|11=A3|41=A2|38=12|10=000|"
+			"8=FIX.4.4|35=9|11=A3|41=A2|10=000|"
+			"8=FIX.4.4|35=8|150=2|11=A2|32=10|10=000|"
+			"8=FIX.4.4|35=8|150=1|11=A9|32=1|10=000|"
+			"8=FIX.4.4|35=9|11=A4|10=000|"
+			"8=FIX.4.4|35=D|11=B1|54=2|44=99");
+
+		size_t consumed = parser.parse(messages.data(), messages.size());
+		check(consumed == messages.rfind("8=FIX.4.4"), "fix: trailing partial message left");
+		check(parser.getRejectedMessages() == 1, "fix: reject without OrigClOrdID not mapped");
+		check(parser.getFailedRequests() == 1 && parser.getLastFailure() == OrderStatus::UnknownId, "fix: fill of an unknown order reported");
+
+		OrderKey original;
+		OrderKey::parse("A1", 2, original);
+		const Order* order = manager.findOrder(original);
+		check(order != nullptr, "fix: order tracked under its original ClOrdID");
+		if (order != nullptr)
+		{
+			check(order->Side() == 'B' && order->Price() == 100.25 && order->TotalQuantity() == 15, "fix: insert and replace round trip");
+			check(order->filledQuantity == 15 && order->remainingQuantity == 0 && order->orderState == OrderState::Completed, "fix: fills after a replace reach the order");
+		}
+
+		// quantities are unsigned in FIX
+		string negative = fixMessages("8=FIX.4.4|35=D|11=C1|54=1|44=100|38=-5|10=000|8=FIX.4.4|35=8|150=1|11=A1|32=-1|10=000|");
+		parser.parse(negative.data(), negative.size());
+		OrderKey rejected;
+		OrderKey::parse("C1", 2, rejected);
+		check(parser.getRejectedMessages() == 3 && manager.findOrder(rejected) == nullptr, "fix: negative quantities rejected");
+	}
+
+	bool sameAggregates(const AggregateSnapshot& a, const AggregateSnapshot& b)
+	{
+		bool same = a.nfq == b.nfq;
+		for (int index = 0; index < 2; ++index)
+			same = same && a.cov[index] == b.cov[index] && a.pov_min[index] == b.pov_min[index] && a.pov_max[index] == b.pov_max[index];
+		return same;
+	}
+
+	void testEventStatuses()
+	{
+		static_assert(noexcept(std::declval<OrderManager&>().OnOrderFilled(std::declval<const OrderKey&>(), 1)), "handlers are noexcept");
+		static_assert(noexcept(std::declval<OrderManager&>().applyEvents(nullptr, 0, nullptr)), "batches are noexcept");
+
+		EventRecord events[8] = {};
+		const EventType types[8] = { EventType::Insert, EventType::Insert, EventType::Acknowledge, EventType::Acknowledge,
+			EventType::Replace, EventType::Replace, EventType::Fill, EventType::Fill };
+		const int ids[8] = { 1, 1, 1, 1, 1, 1, 9, 1 };
+		for (int i = 0; i < 8; ++i)
+		{
+			events[i].type = types[i];
+			events[i].id = OrderKey(ids[i]);
+			events[i].side = 'B';
+			events[i].price = 10.0;
+			events[i].quantity = 5;
+			events[i].newId = OrderKey(2);
+			events[i].deltaQuantity = 1;
+		}
+
+		OrderManager manager;
+		OrderStatus statuses[8];
+		size_t failed = manager.applyEvents(events, 8, statuses);
+		const OrderStatus expected[8] = { OrderStatus::Ok, OrderStatus::DuplicateId, OrderStatus::Ok, OrderStatus::NotPending,
+			OrderStatus::Ok, OrderStatus::AlreadyPending, OrderStatus::UnknownId, OrderStatus::Ok };
+		bool matches = failed == 4;
+		for (int i = 0; i < 8; ++i)
+			matches = matches && statuses[i] == expected[i];
+		check(matches, "status: every refused event reported, and counted by the batch");
+
+		OrderManager reference;
+		reference.OnInsertOrderRequest(1, 'B', 10.0, 5);
+		reference.OnRequestAcknowledged(1);
+		reference.OnReplaceOrderRequest(1, 2, 1);
+		reference.OnOrderFilled(1, 5);
+		check(manager.getStateHash() == reference.getStateHash(), "status: refused events leave the state unchanged");
+		check(manager.OnRequestRejected(OrderKey(3)) == OrderStatus::UnknownId && manager.applyEvents(events, 1, nullptr) == 1, "status: single handlers and batches without statuses");
+	}
+
+	void testCompensatedAggregates()
+	{
+		// additions matched by subtractions leave exactly 0, where a plain double keeps a residue
+		CompensatedSum sum;
+		double plain = 0.0;
+		for (int i = 0; i < 100000; ++i)
+		{
+			sum.add(10.01 + i % 7 * 0.01, 3);
+			plain += (10.01 + i % 7 * 0.01) * 3;
+		}
+		for (int i = 0; i < 100000; ++i)
+		{
+			sum.add(10.01 + i % 7 * 0.01, -3);
+			plain -= (10.01 + i % 7 * 0.01) * 3;
+		}
+		check(sum.value() == 0 && plain != 0, "compensated: matched subtractions cancel exactly");
+
+		OrderManager manager;
+		for (int id = 1; id <= 1000; ++id)
+		{
+			manager.OnInsertOrderRequest(id, (id % 2) ? 'B' : 'O', 10.01 + id % 13 * 0.07, 100 + id % 9);
+			manager.OnRequestAcknowledged(id);
+			manager.OnOrderFilled(id, id % 50);
+		}
+		AggregateValues recomputed = manager.recomputeAggregates();
+		long double correction = manager.reconcileAggregates();
+		check(correction < 1e-6, "compensated: incremental values do not drift");
+		check(manager.getCOV('B') == recomputed.cov[1] && manager.getCOV('O') == recomputed.cov[0] && manager.getPOV_max('B') == recomputed.pov_max[1],
+			"compensated: reconciliation replaces the values with the recomputed ones");
+	}
+
+	void testRebuildAggregates()
+	{
+		OrderManager manager;
+		manager.OnInsertOrderRequest(1, 'B', 10.1, 30);
+		manager.OnInsertOrderRequest(2, 'O', 20.3, 40);
+		manager.OnInsertOrderRequest(3, 'B', 10.7, 5);
+		manager.OnRequestAcknowledged(1);
+		manager.OnRequestAcknowledged(2);
+		manager.OnOrderFilled(1, 10);
+		manager.OnReplaceOrderRequest(2, 4, -15);
+		manager.OnOrderFilled(2, 5);
+
+		AggregateSnapshot before = manager.Snapshot();
+		check(manager.rebuildAggregates() < 1e-9, "rebuild: no drift on an exact book");
+		check(sameAggregates(before, manager.Snapshot()), "rebuild: kernel values equal the incremental values");
+
+		// the contributing counts are rebuilt too: removing the last contributions leaves exact zeros
+		manager.OnRequestRejected(3);
+		manager.OnRequestAcknowledged(2);
+		manager.OnOrderFilled(1, 20);
+		manager.OnOrderFilled(2, 20);
+		AggregateSnapshot empty = manager.Snapshot();
+		check(empty.cov[0] == 0 && empty.cov[1] == 0 && empty.pov_min[1] == 0 && empty.pov_max[1] == 0, "rebuild: contributing order counts rebuilt");
+	}
+
+	void testStateHash()
+	{
+		// every kind of event, so each group of fields is rehashed incrementally at least once
+		OrderManager hashing, deferred;
+		deferred.setStateHashing(false);
+		OrderManager* managers[2] = { &hashing, &deferred };
+		for (OrderManager* manager : managers)
+		{
+			manager->OnInsertOrderRequest(1, 'B', 10.5, 30);
+			manager->OnInsertOrderRequest(2, 'O', 11.0, 20);
+			manager->OnInsertOrderRequest(3, 'B', 9.5, 10);
+			manager->OnRequestAcknowledged(1);
+			manager->OnRequestAcknowledged(2);
+			manager->OnRequestRejected(3);
+			manager->OnReplaceOrderRequest(1, 11, 5);
+			manager->OnOrderFilled(1, 10);
+			manager->OnRequestAcknowledged(1);
+			manager->OnReplaceOrderRequest(2, 12, -5);
+			manager->OnRequestRejected(2);
+			manager->OnOrderFilled(2, 20);
+		}
+		check(deferred.getStateHash() != hashing.getStateHash(), "hash: orders not covered while hashing is off");
+		deferred.setStateHashing(true);
+		check(deferred.getStateHash() == hashing.getStateHash(), "hash: incremental hash equals a full rehash");
+
+		OrderManager other;
+		other.OnInsertOrderRequest(1, 'B', 10.5, 30);
+		OrderManager swapped;
+		swapped.OnInsertOrderRequest(1, 'O', 10.5, 30);
+		check(other.getStateHash() != swapped.getStateHash(), "hash: side covered");
+
+		BasicOrderManager<NFQOnlyMetrics> unhashed;
+		unhashed.setStateHashing(true);
+		unhashed.OnInsertOrderRequest(1, 'B', 10.5, 30);
+		BasicOrderManager<NFQOnlyMetrics> empty;
+		check(unhashed.getStateHash() == empty.getStateHash(), "hash: compiled out by the policy");
+	}
+
+	void testQueryServer()
+	{
+		const char* name = "OrderManagerSelfTestQueries";
+		OrderManager manager;
+		QueryServer server(manager);
+		QueryClient client;
+		check(server.create(name) && client.open(name), "query: channel opened");
+
+		manager.OnInsertOrderRequest(1, 'B', 10.0, 5);
+		manager.OnRequestAcknowledged(1);
+		server.publish();
+		AggregateQueryResult aggregates;
+		check(client.readAggregates(aggregates) && aggregates.cov[1] == 50.0 && aggregates.version == 2, "query: aggregates read");
+
+		// a server stopped in the middle of a publish leaves the sequence odd
+		SharedMemory view;
+		check(view.open(name, sizeof(QueryChannel)), "query: channel mapped");
+		static_cast<QueryChannel*>(view.data())->sequence.fetch_add(1);
+		check(!client.readAggregates(aggregates, 1000), "query: aggregate read gives up on a stopped publish");
+	}
+
+	void testHugePageResource()
+	{
+		// a 1GB page pool is rarely configured: the fallback must not map (and prefault) a whole gigabyte for 3MB
+		HugePageResource resource;
+		check(resource.reserve(size_t(3) << 20, HugePageSize::Size1GB, true), "huge pages: reserved");
+		check(resource.getBacking() == PageBacking::HugePages || resource.getCapacity() == (size_t(4) << 20), "huge pages: fallback rounded to 2MB");
+	}
+
+	void testEventFileLoader()
+	{
+		const string text =
+			"type,id,side,price,qty,newId,delta\n"	// header
+			"I,1,B,10.5,30,,\n"
+			"# comment\n"
+			"\n"
+			"I,2,B,10.5,-30,,\n"	// negative insert quantity
+			"I,3,B,10.5,0,,\n"	// zero insert quantity
+			"A,1,,,,,\n"
+			"F,1,,,-5,,\n"	// negative fill
+			"F,1,,,+5,,\n"	// sign not accepted
+			"F,1,,,5,,\n"
+			"R,1,,,,ORD-2,-10\n"
+			"Z,1,,,,,\n";	// unknown type
+		EventFileLoader loader;
+		loader.parse(text.data(), text.size(), 2);
+		check(loader.getEvents().size() == 4 && loader.getMalformedLines() == 6, "loader: malformed and non-positive quantities skipped");
+
+		OrderManager manager;
+		loader.replay(manager);
+		const Order* order = manager.findOrder(1);
+		check(order != nullptr && order->filledQuantity == 5 && order->orderState == OrderState::ReplacePending && manager.findOrder(2) == nullptr, "loader: valid lines replayed");
+	}
+
+	void testEndOfDayReconciler()
+	{
+		OrderManager manager;
+		manager.OnInsertOrderRequest(1, 'B', 10.0, 10);
+		manager.OnRequestAcknowledged(1);
+		manager.OnOrderFilled(1, 5);
+		manager.OnInsertOrderRequest(2, 'O', 11.0, 8);
+		manager.OnRequestAcknowledged(2);
+		manager.OnInsertOrderRequest(3, 'B', 12.0, 4);
+		manager.OnRequestRejected(3);
+		manager.OnInsertOrderRequest(5, 'B', 13.0, 2);
+		manager.OnRequestAcknowledged(5);
+
+		const string exchange =
+			"1,B,10.0,5,5,PartiallyFilled\n"
+			"2,O,11.0,7,0,active\n"	// remaining differs
+			"4,B,9.0,3,0,Active\n"	// unknown to the manager
+			"not,a,record\n";
+		EndOfDayReconciler reconciler;
+		reconciler.parseExchangeRecords(exchange.data(), exchange.size(), 2);
+		vector<ReconciliationBreak> breaks = reconciler.reconcile(manager, 2);
+		check(reconciler.getMalformedLines() == 1 && breaks.size() == 3, "reconcile: one break per differing order, rejected order ignored");
+		check(breaks.size() == 3 && breaks[0].id == OrderKey(2) && breaks[0].type == BreakType::Mismatch && breaks[0].fields == BreakRemaining
+			&& breaks[1].id == OrderKey(4) && breaks[1].type == BreakType::MissingInManager
+			&& breaks[2].id == OrderKey(5) && breaks[2].type == BreakType::MissingAtExchange, "reconcile: breaks typed and ordered by id");
+	}
+
+	void testStandbyReplica()
+	{
+		const char* name = "OrderManagerSelfTestJournal";
+		{
+			OrderManager primary;
+			JournalWriter journal(primary);
+			StandbyReplica standby;
+			check(journal.create(name, 64) && standby.open(name), "replica: journal opened");
+
+			journal.OnInsertOrderRequest(1, 'B', 10.5, 30);
+			journal.OnInsertOrderRequest(2, 'O', 11.0, 20);
+			journal.OnRequestAcknowledged(1);
+			journal.OnReplaceOrderRequest(2, 3, 5);
+			journal.OnOrderFilled(1, 10);
+			journal.publishStateHash(primary.getStateHash());
+
+			check(standby.poll() == 5 && standby.getLag() == 0, "replica: every event applied");
+			check(standby.getManager().getStateHash() == primary.getStateHash() && !standby.hasDiverged(), "replica: state hash equals the primary's");
+			check(standby.promote() == &standby.getManager(), "replica: promoted");
+		}
+		{
+			// string ids from FIX are journaled as they arrive
+			OrderManager primary;
+			JournalWriter journal(primary);
+			FixParser parser(primary, journal);
+			StandbyReplica standby;
+			check(journal.create(name, 64) && standby.open(name), "replica: journal opened for FIX");
+
+			string messages = fixMessages(
+				"8=FIX.4.4|35=D|11=ORD-1|54=1|44=50.5|38=10|10=000|"
+				"8=FIX.4.4|35=8|150=0|11=ORD-1|10=000|"
+				"8=FIX.4.4|35=G|11=ORD-2|41=ORD-1|38=12|10=000|"
+				"8=FIX.4.4|35=8|150=5|11=ORD-2|41=ORD-1|10=000|"
+				"8=FIX.4.4|35=8|150=1|11=ORD-2|32=4|10=000|");
+			parser.parse(messages.data(), messages.size());
+
+			OrderKey id;
+			OrderKey::parse("ORD-1", 5, id);
+			const Order* order = nullptr;
+			check(standby.poll() == 5 && (order = standby.getManager().findOrder(id)) != nullptr && order->filledQuantity == 4, "replica: string ids journaled");
+			check(standby.getManager().getStateHash() == primary.getStateHash(), "replica: state hash equals the primary's with string ids");
+		}
+		{
+			OrderManager primary;
+			JournalWriter journal(primary);
+			StandbyReplica standby;
+			check(journal.create(name, 64) && standby.open(name), "replica: journal reopened");
+
+			journal.OnInsertOrderRequest(1, 'B', 10.5, 30);
+			StateHash wrong = primary.getStateHash();
+			++wrong.low;
+			journal.publishStateHash(wrong);
+			check(standby.promote() == nullptr && standby.hasDiverged(), "replica: diverged standby not promoted");
+		}
+		{
+			// a caught-up standby applies the event before the primary publishes its hash
+			OrderManager primary;
+			JournalWriter journal(primary);
+			StandbyReplica standby;
+			check(journal.create(name, 64) && standby.open(name), "replica: journal opened for a caught-up standby");
+
+			journal.OnInsertOrderRequest(1, 'B', 10.5, 30);
+			check(standby.poll() == 1 && !standby.isVerified(), "replica: applied before the hash is published");
+			check(standby.promote() == nullptr && !standby.hasDiverged(), "replica: unverified standby not promoted");
+
+			StateHash wrong = primary.getStateHash();
+			++wrong.high;
+			journal.publishStateHash(wrong);
+			check(standby.poll() == 0 && standby.hasDiverged() && standby.promote() == nullptr, "replica: hash checked by a poll applying nothing");
+		}
+		{
+			OrderManager primary;
+			JournalWriter journal(primary);
+			StandbyReplica standby;
+			check(journal.create(name, 64) && standby.open(name), "replica: journal opened for a late hash");
+
+			journal.OnInsertOrderRequest(1, 'B', 10.5, 30);
+			standby.poll();
+			journal.publishStateHash(primary.getStateHash());
+			check(standby.promote() == &standby.getManager() && standby.isVerified(), "replica: promoted once the hash is published");
+		}
+		{
+			OrderManager primary;
+			JournalWriter journal(primary);
+			StandbyReplica standby;
+			check(journal.create(name, 2) && standby.open(name), "replica: small journal opened");
+
+			for (int id = 1; id <= 5; ++id)
+				journal.OnInsertOrderRequest(id, 'B', 10.0, 1);
+			check(standby.promote() == nullptr && standby.hasLostEvents(), "replica: lagging standby not promoted");
+		}
+	}
+
+	void testSnapshotRestore()
+	{
+		OrderManager live;
+		live.OnInsertOrderRequest(1, 'B', 10.1, 30);
+		live.OnInsertOrderRequest(2, 'O', 20.3, 40);
+		live.OnRequestAcknowledged(1);
+		live.OnRequestAcknowledged(2);
+
+		stringstream base;
+		check(OrderSnapshot::write(live, base, SnapshotKind::Base), "snapshot: base written");
+
+		// only orders 1, 2 and 3 change: an acknowledged replace, a pending replace, a fill and a new order
+		live.OnReplaceOrderRequest(1, 11, 10);
+		live.OnRequestAcknowledged(1);
+		live.OnReplaceOrderRequest(2, 12, -5);
+		live.OnOrderFilled(2, 15);
+		live.OnInsertOrderRequest(3, 'B', 10.9, 7);
+
+		stringstream delta;
+		check(OrderSnapshot::write(live, delta, SnapshotKind::Delta), "snapshot: delta written");
+
+		OrderManager restored;
+		check(OrderSnapshot::read(restored, base) && OrderSnapshot::read(restored, delta), "snapshot: base and delta read");
+		check(restored.getStateHash() == live.getStateHash(), "snapshot: restored state hash equals the live one");
+		check(sameAggregates(restored.Snapshot(), live.Snapshot()), "snapshot: restored aggregates equal the live ones");
+
+		// the restored state keeps evolving like the live one, pending replace and contributing counts included
+		OrderManager* managers[2] = { &live, &restored };
+		for (OrderManager* manager : managers)
+		{
+			manager->OnRequestAcknowledged(2);
+			manager->OnRequestRejected(3);
+			manager->OnOrderFilled(2, 20);
+			manager->OnOrderFilled(1, 40);
+		}
+		check(restored.getStateHash() == live.getStateHash() && sameAggregates(restored.Snapshot(), live.Snapshot()), "snapshot: restored state evolves like the live one");
+		check(restored.Snapshot().cov[0] == 0 && restored.Snapshot().cov[1] == 0, "snapshot: contributing counts restored");
+
+		// other policies: custom aggregates are rebuilt by read()
+		AggregateDefinition bidNotional;
+		bidNotional.name = "bidNotional";
+		bidNotional.sides = AggregateDefinition::Buy;
+		bidNotional.notional = true;
+		PlannedOrderManager planned, plannedRestored;
+		planned.getMetrics().plan.add(bidNotional);
+		plannedRestored.getMetrics().plan.add(bidNotional);
+		planned.OnInsertOrderRequest(1, 'B', 10.5, 30);
+		planned.OnInsertOrderRequest(2, 'B', 11.0, 10);
+		stringstream plannedBase;
+		OrderSnapshot::write(planned, plannedBase, SnapshotKind::Base);
+		planned.OnRequestAcknowledged(1);
+		planned.OnOrderFilled(1, 20);
+		stringstream plannedDelta;
+		OrderSnapshot::write(planned, plannedDelta, SnapshotKind::Delta);
+		check(OrderSnapshot::read(plannedRestored, plannedBase) && OrderSnapshot::read(plannedRestored, plannedDelta)
+			&& plannedRestored.getStateHash() == planned.getStateHash()
+			&& plannedRestored.getMetrics().plan.value(0) == planned.getMetrics().plan.value(0) && planned.getMetrics().plan.value(0) == 215.0, "snapshot: custom aggregates rebuilt on restore");
+
+		// the orders dropped by a reset are not in the dirty set: the checkpoint after it is a base
+		OrderManager session, sessionRestored;
+		session.OnInsertOrderRequest(1, 'B', 10.0, 5);
+		session.OnRequestAcknowledged(1);
+		stringstream beforeReset;
+		OrderSnapshot::write(session, beforeReset, SnapshotKind::Base);
+		session.resetSession();
+		check(session.requiresBaseCheckpoint(), "snapshot: reset requires a base");
+		session.OnInsertOrderRequest(2, 'O', 11.0, 7);
+		stringstream afterReset;
+		OrderSnapshot::write(session, afterReset, SnapshotKind::Delta);
+		check(!session.requiresBaseCheckpoint() && OrderSnapshot::read(sessionRestored, beforeReset) && OrderSnapshot::read(sessionRestored, afterReset)
+			&& sessionRestored.findOrder(1) == nullptr && sessionRestored.getStateHash() == session.getStateHash(), "snapshot: no dropped order restored after a reset");
+		session.OnOrderFilled(1, 5);
+		sessionRestored.OnOrderFilled(1, 5);
+		check(sameAggregates(sessionRestored.Snapshot(), session.Snapshot()), "snapshot: restored state after a reset evolves like the live one");
+	}
+
+	void testSessionReset()
+	{
+		SessionArena arena;
+		OrderManager manager(&arena);
+		auto session = [&manager](int firstId)
+		{
+			for (int id = firstId; id < firstId + 2000; ++id)
+			{
+				manager.OnInsertOrderRequest(id, 'B', 10.0 + id % 5, 10);
+				manager.OnRequestAcknowledged(id);
+				manager.OnReplaceOrderRequest(id, id + 100000, 5);
+			}
+		};
+		session(1);
+		size_t reserved = arena.getReservedBytes();
+		manager.resetSession();
+		check(manager.findOrder(1) == nullptr && manager.getNFQ() == 0 && manager.getPOV_max('B') == 0 && manager.getStateHash() == OrderManager().getStateHash(),
+			"reset: orders, aggregates and hash dropped");
+		session(1);
+		check(arena.getReservedBytes() == reserved, "reset: the next session reuses the arena blocks");
+
+		// reset -> snapshot -> restore -> compare
+		manager.resetSession();
+		manager.OnInsertOrderRequest(7, 'O', 20.0, 3);
+		manager.OnRequestAcknowledged(7);
+		manager.OnOrderFilled(7, 1);
+		stringstream checkpoint;
+		OrderSnapshot::write(manager, checkpoint, SnapshotKind::Base);
+		OrderManager restored;
+		restored.OnInsertOrderRequest(1, 'B', 10.0, 10);
+		check(OrderSnapshot::read(restored, checkpoint) && restored.findOrder(1) == nullptr && restored.findOrder(7) != nullptr
+			&& restored.getStateHash() == manager.getStateHash() && sameAggregates(restored.Snapshot(), manager.Snapshot()), "reset: snapshot after a reset restores the new session only");
+	}
+
+	// counts the bytes outstanding, to check every allocation of a manager goes through the resource it was given
+	class CountingResource : public std::pmr::memory_resource
+	{
+	public:
+		size_t outstanding = 0;
+
+	protected:
+		virtual void* do_allocate(size_t size, size_t alignment) override
+		{
+			outstanding += size;
+			return std::pmr::new_delete_resource()->allocate(size, alignment);
+		}
+		virtual void do_deallocate(void* p, size_t size, size_t alignment) override
+		{
+			outstanding -= size;
+			std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+		}
+		virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+	};
+
+	void testMemoryResource()
+	{
+		CountingResource resource;
+		{
+			OrderManager manager(&resource);
+			size_t empty = resource.outstanding;
+			for (int id = 1; id <= 1000; ++id)
+			{
+				manager.OnInsertOrderRequest(id, 'B', 10.0, 10);
+				manager.OnReplaceOrderRequest(id, id + 1000, 5);
+			}
+			check(resource.outstanding > empty + 1000 * sizeof(Order), "pmr: orders and tables allocated from the resource");
+
+			// not an arena: resetSession() destroys and deallocates everything
+			manager.resetSession();
+			check(resource.outstanding == empty, "pmr: session memory returned on reset");
+		}
+		check(resource.outstanding == 0, "pmr: everything returned on destruction");
+	}
+
+	void testAggregatePlan()
+	{
+		PlannedOrderManager manager;
+		AggregatePlan& plan = manager.getMetrics().plan;
+		for (int band = 0; band < 2; ++band)
+		{
+			AggregateDefinition definition;
+			definition.name = band == 0 ? "band100" : "band101";
+			definition.minPrice = 100.0 + band;
+			definition.maxPrice = 101.0 + band;
+			definition.quantity = AggregateQuantity::One;
+			plan.add(definition);
+		}
+		const double prices[5] = { 100.0, 100.99, 101.0, 101.5, 102.0 };
+		for (int i = 0; i < 5; ++i)
+			manager.OnInsertOrderRequest(i + 1, 'B', prices[i], 10);
+		check(plan.value(0) == 2 && plan.value(1) == 2, "plan: adjacent price bands do not overlap");
+	}
+
+	void testAggregateHistory()
+	{
+		EventRecord script[10] = {};
+		const int ids[10] = { 1, 2, 1, 2, 1, 3, 1, 3, 2, 3 };
+		const EventType types[10] = { EventType::Insert, EventType::Insert, EventType::Acknowledge, EventType::Acknowledge, EventType::Fill,
+			EventType::Insert, EventType::Replace, EventType::Reject, EventType::Fill, EventType::Insert };
+		for (int i = 0; i < 10; ++i)
+		{
+			script[i].type = types[i];
+			script[i].id = OrderKey(ids[i]);
+			script[i].side = (i % 2) ? 'O' : 'B';
+			script[i].price = 10.0 + i;
+			script[i].quantity = 10 + i;
+			script[i].newId = OrderKey(ids[i] + 100);
+			script[i].deltaQuantity = 5;
+		}
+
+		// automatic checkpoints every 3 events (a base every 2), and manual ones
+		OrderManager automatic, manual;
+		AggregateHistory history(automatic, 3, 2);
+		AggregateHistory idleHistory(manual, 0);
+		for (int i = 0; i < 10; ++i)
+		{
+			history.record(script[i], 1000 * (i + 1));
+			idleHistory.record(script[i], 1000 * (i + 1));
+			if (i == 4)
+				idleHistory.checkpoint();
+		}
+
+		bool matches = true;
+		for (int sequence = 0; sequence <= 10; ++sequence)
+		{
+			OrderManager reference;
+			reference.applyEvents(script, sequence, nullptr);
+			AggregateSnapshot atSequence, atTime, idle;
+			matches = matches && history.queryAtSequence(sequence, atSequence) && sameAggregates(atSequence, reference.Snapshot());
+			matches = matches && history.queryAtTime(1000 * sequence + 500, atTime) && sameAggregates(atTime, reference.Snapshot());
+			matches = matches && idleHistory.queryAtSequence(sequence, idle) && sameAggregates(idle, reference.Snapshot());
+		}
+		check(matches, "history: every point in time equals a replay from the start");
+
+		// target reset in the middle of the script: from that point on, queries replay from the empty book only
+		OrderManager resetTarget;
+		AggregateHistory resetHistory(resetTarget, 2, 4);
+		for (int i = 0; i < 10; ++i)
+		{
+			if (i == 5)
+				resetTarget.resetSession();
+			resetHistory.record(script[i], 1000 * (i + 1));
+		}
+		bool resetMatches = true;
+		for (int sequence = 0; sequence <= 10; ++sequence)
+		{
+			OrderManager reference;
+			if (sequence < 5)
+				reference.applyEvents(script, sequence, nullptr);
+			else
+				reference.applyEvents(script + 5, sequence - 5, nullptr);
+			AggregateSnapshot atSequence;
+			resetMatches = resetMatches && resetHistory.queryAtSequence(sequence, atSequence) && sameAggregates(atSequence, reference.Snapshot());
+		}
+		check(resetMatches, "history: no replay across a reset of the target");
+
+		// timestamps taken by the history are wall-clock
+		OrderManager live;
+		AggregateHistory clocked(live);
+		uint64_t before = wallClockNanos();
+		clocked.OnInsertOrderRequest(OrderKey(1), 'B', 10.0, 5);
+		AggregateSnapshot beforeInsert, afterInsert;
+		check(clocked.queryAtTime(before - 1000000000, beforeInsert) && beforeInsert.pov_max[1] == 0
+			&& clocked.queryAtTime(wallClockNanos() + 1000000000, afterInsert) && afterInsert.pov_max[1] == 50, "history: queried by wall-clock time");
+	}
+
+	void testOrderManagerHost()
+	{
+		OrderKey ids[4];
+		ids[0] = OrderKey(int64_t(42));
+		ids[1] = OrderKey(int64_t(-7));
+		OrderKey::parse("ABCDEFGHIJK", 11, ids[2]);
+		OrderKey::parse("X", 1, ids[3]);
+		const uint32_t tenants[3] = { 0, 5, 0xFFFFFFFE };
+
+		bool roundTrips = true;
+		bool distinct = true;
+		for (const OrderKey& id : ids)
+		{
+			OrderKey keys[3];
+			for (int t = 0; t < 3; ++t)
+			{
+				roundTrips = roundTrips && OrderManagerHost::qualify(tenants[t], id, keys[t]) && OrderManagerHost::unqualify(keys[t]) == id
+					&& OrderManagerHost::unqualify(keys[t]).toString() == id.toString();
+				distinct = distinct && keys[t] != id && keys[t].toString().size() <= OrderManagerHost::MaxStringLength;
+			}
+			distinct = distinct && keys[0] != keys[1] && keys[1] != keys[2] && keys[0] != keys[2];
+		}
+		check(roundTrips, "host: unqualify(qualify(id)) is id");
+		check(distinct, "host: qualified keys differ per tenant and from plain ids");
+
+		OrderKey tooLong, key;
+		OrderKey::parse("ABCDEFGHIJKL", 12, tooLong);
+		check(!OrderManagerHost::qualify(0, tooLong, key), "host: string ids longer than MaxStringLength refused");
+
+		OrderManagerHost host(2);
+		check(host.OnInsertOrderRequest(0, ids[2], 'B', 10.0, 5) == OrderStatus::Ok && host.OnInsertOrderRequest(1, ids[2], 'O', 11.0, 7) == OrderStatus::Ok, "host: same id in two tenants");
+		check(host.OnInsertOrderRequest(2, ids[0], 'B', 10.0, 5) == OrderStatus::UnknownTenant && host.OnInsertOrderRequest(0, tooLong, 'B', 10.0, 5) == OrderStatus::InvalidId, "host: unknown tenant and invalid id refused");
+		const Order* order = host.findOrder(1, ids[2]);
+		check(order != nullptr && order->TotalQuantity() == 7 && OrderManagerHost::unqualify(order->Id()) == ids[2], "host: orders found per tenant");
+	}
+
+	// upper bound of the bucket holding nanos, as reported by percentile()
+	uint64_t bucketEnd(uint64_t nanos)
+	{
+		LatencyHistogram histogram;
+		histogram.record(nanos);
+		histogram.record(UINT64_MAX);
+		return histogram.percentile(0.0);
+	}
+
+	void testLatencyHistogram()
+	{
+		bool bounded = true;
+		bool contiguous = true;
+		for (unsigned bit = 0; bit < 64; ++bit)
+		{
+			uint64_t power = uint64_t(1) << bit;
+			const uint64_t values[5] = { power - 1, power, power + 1, power + power / 3, power + power / 2 };
+			for (uint64_t value : values)
+			{
+				uint64_t end = bucketEnd(value);
+				bounded = bounded && end >= value && end - value <= value / LatencyHistogram::SubBuckets;
+				// the next value is in the same bucket, or value ended its bucket
+				uint64_t next = value + 1;
+				contiguous = contiguous && (next == 0 || bucketEnd(next) == end || end == value);
+			}
+		}
+		for (uint64_t value = 0; value < 4096; ++value)
+		{
+			uint64_t end = bucketEnd(value);
+			bounded = bounded && end >= value && end - value <= value / LatencyHistogram::SubBuckets;
+			contiguous = contiguous && (bucketEnd(value + 1) == end || end == value);
+		}
+		check(bounded, "histogram: every value within 1/SubBuckets below its bucket bound");
+		check(contiguous, "histogram: buckets are contiguous");
+		check(bucketEnd(UINT64_MAX) == UINT64_MAX && bucketEnd(0) == 0, "histogram: extreme buckets");
+
+		LatencyHistogram histogram;
+		for (uint64_t nanos = 1; nanos <= 100; ++nanos)
+			histogram.record(nanos * 1000);
+		check(histogram.getMin() == 1000 && histogram.getMax() == 100000 && histogram.percentile(1.0) == 100000, "histogram: min, max and top percentile");
+		uint64_t median = histogram.percentile(0.5);
+		check(median >= 51000 && median - 51000 <= 51000 / LatencyHistogram::SubBuckets, "histogram: median within a bucket");
+	}
+
+	void testWarmUp()
+	{
+		OrderManager manager;
+		OrderAuditTrail trail;
+		RoundTripLatency latency;
+		OrderLifetimeAnalytics analytics;
+		manager.setAuditTrail(&trail);
+		manager.setLatencyTracker(&latency);
+		manager.setLifetimeAnalytics(&analytics);
+		check(manager.warmUp(64) && trail.getCount() == 0, "warm-up: audit trail untouched");
+		check(latency.get(EventType::Insert, 'B').getCount() == 0 && latency.get(EventType::Replace, 'O').getCount() == 0, "warm-up: latency untouched");
+		check(analytics.getCompletedOrders() == 0 && analytics.getRejectedOrders() == 0, "warm-up: analytics untouched");
+
+		manager.OnInsertOrderRequest(1, 'B', 10.0, 5);
+		manager.OnRequestAcknowledged(1);
+		manager.OnOrderFilled(1, 5);
+		check(trail.getCount() == 3, "warm-up: audit trail attached again");
+		check(analytics.getCompletedOrders() == 1, "warm-up: analytics attached again");
+		check(latency.get(EventType::Insert, 'B').getCount() == 1, "warm-up: latency attached again");
+	}
+
+	void testLifetimeAnalytics()
+	{
+		OrderManager manager;
+		OrderLifetimeAnalytics analytics;
+		manager.setLifetimeAnalytics(&analytics);
+
+		// 10 requested, 4 filled, then reduced by 6: completed at 40% of the peak
+		manager.OnInsertOrderRequest(1, 'B', 10.0, 10);
+		manager.OnRequestAcknowledged(1);
+		manager.OnOrderFilled(1, 4);
+		manager.OnReplaceOrderRequest(1, 2, -6);
+		manager.OnRequestAcknowledged(1);
+		check(manager.findOrder(1)->orderState == OrderState::Completed && analytics.getCompletedOrders() == 1, "analytics: reduced order completed");
+		check(analytics.getFillRatios().getCount(40) == 1, "analytics: fill ratio against the peak quantity");
+
+		// raised from 5 to 8 and fully filled: 100%
+		manager.OnInsertOrderRequest(3, 'S', 10.0, 5);
+		manager.OnRequestAcknowledged(3);
+		manager.OnReplaceOrderRequest(3, 4, 3);
+		manager.OnRequestAcknowledged(3);
+		manager.OnOrderFilled(3, 8);
+		check(analytics.getFillRatios().getCount(100) == 1, "analytics: peak raised by a replace");
+
+		// still open at the end of the session, 25% filled
+		manager.OnInsertOrderRequest(5, 'B', 10.0, 4);
+		manager.OnRequestAcknowledged(5);
+		manager.OnOrderFilled(5, 1);
+		manager.resetSession();
+		check(analytics.getOpenOrders() == 1 && analytics.getOpenFillRatios().getCount(25) == 1, "analytics: open orders summarised at reset");
+		check(analytics.getCompletedOrders() == 2, "analytics: open orders not counted as completed");
+
+		// filled out while a replace is pending, then the replace is rejected
+		manager.OnInsertOrderRequest(6, 'B', 10.0, 5);
+		manager.OnRequestAcknowledged(6);
+		manager.OnReplaceOrderRequest(6, 7, 2);
+		manager.OnOrderFilled(6, 5);
+		manager.OnRequestRejected(6);
+		check(manager.findOrder(6)->orderState == OrderState::Completed && analytics.getCompletedOrders() == 3, "analytics: completed by a rejected replace");
+
+		// a completed order reduced further stays completed and is counted once
+		manager.OnInsertOrderRequest(8, 'S', 10.0, 5);
+		manager.OnRequestAcknowledged(8);
+		manager.OnOrderFilled(8, 5);
+		manager.OnReplaceOrderRequest(8, 9, -2);
+		manager.OnRequestAcknowledged(8);
+		check(manager.findOrder(8)->orderState == OrderState::Completed && analytics.getCompletedOrders() == 4, "analytics: completed order not counted again");
+		manager.resetSession();
+		check(analytics.getOpenOrders() == 1, "analytics: completed orders not open at reset");
+
+		FillRatioHistogram ratios;
+		ratios.record(29, 100);
+		ratios.record(1, 3);
+		ratios.record(7, 5);
+		check(ratios.getCount(29) == 1 && ratios.getCount(33) == 1 && ratios.getCount(FillRatioHistogram::Overfilled) == 1, "analytics: fill ratio buckets in whole percents");
+	}
+
+#if defined(ORDERMANAGER_COROUTINES)
+	OrderTask insertThenReplace(OrderManager& manager, RequestOutcome* outcomes)
+	{
+		outcomes[0] = co_await insertRequest(manager, OrderKey(1), 'B', 10.0, 5);
+		outcomes[1] = co_await replaceRequest(manager, OrderKey(1), OrderKey(2), 3);
+		outcomes[2] = co_await insertRequest(manager, OrderKey(1), 'B', 10.0, 5);
+	}
+
+	OrderTask insertThenReplaceThrough(OrderKeyListener& entry, OrderManager& manager, RequestOutcome* outcomes)
+	{
+		outcomes[0] = co_await insertRequest(entry, manager, OrderKey(1), 'B', 10.0, 5);
+		outcomes[1] = co_await replaceRequest(entry, manager, OrderKey(1), OrderKey(2), 3);
+	}
+
+	void testRequestAwaiter()
+	{
+		OrderManager manager;
+		RequestOutcome outcomes[3] = {};
+		insertThenReplace(manager, outcomes);
+		check(manager.findOrder(1) != nullptr && manager.findOrder(1)->orderState == OrderState::NewPending, "coroutine: suspended on the insert");
+
+		manager.OnRequestAcknowledged(1);
+		check(outcomes[0].status == OrderStatus::Ok && outcomes[0].result == RequestResult::Acknowledged, "coroutine: resumed with the acknowledgement");
+		check(manager.findOrder(1)->orderState == OrderState::ReplacePending, "coroutine: next request made from the continuation");
+
+		manager.OnRequestRejected(1);
+		check(outcomes[1].status == OrderStatus::Ok && outcomes[1].result == RequestResult::Rejected, "coroutine: resumed with the rejection");
+		check(outcomes[2].status == OrderStatus::DuplicateId, "coroutine: refused request does not suspend");
+
+		// through a history in front of the manager, the requests are recorded like any other event
+		OrderManager target;
+		AggregateHistory history(target, 0);
+		RequestOutcome throughHistory[2] = {};
+		insertThenReplaceThrough(history, target, throughHistory);
+		check(history.getSequence() == 1 && target.findOrder(1) != nullptr, "coroutine: request recorded by the history");
+		history.OnRequestAcknowledged(OrderKey(1));
+		check(throughHistory[0].result == RequestResult::Acknowledged && history.getSequence() == 3, "coroutine: resumed through the history");
+		history.OnRequestAcknowledged(OrderKey(1));
+		AggregateSnapshot replayed;
+		check(throughHistory[1].result == RequestResult::Acknowledged && history.queryAtSequence(4, replayed) && sameAggregates(replayed, target.Snapshot()), "coroutine: history replays the requests");
+	}
+#endif
+}
+
+int runSelfTests()
+{
+	testWireProtocol();
+	testFixParser();
+	testEventStatuses();
+	testCompensatedAggregates();
+	testRebuildAggregates();
+	testStateHash();
+	testQueryServer();
+	testHugePageResource();
+	testEventFileLoader();
+	testEndOfDayReconciler();
+	testStandbyReplica();
+	testSnapshotRestore();
+	testSessionReset();
+	testMemoryResource();
+	testAggregatePlan();
+	testAggregateHistory();
+	testOrderManagerHost();
+	testLatencyHistogram();
+	testWarmUp();
+	testLifetimeAnalytics();
+#if defined(ORDERMANAGER_COROUTINES)
+	testRequestAwaiter();
+#endif
+
+	if (failures == 0)
+		printf("self-test passed\n");
+	return failures;
+}
@@ -0,0 +1,9 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+/* Description - Behaviour checks of the components, run by "OrderManager --self-test".
+	 Each failed check is reported on stderr; returns the number of failed checks.
+*/
+int runSelfTests();
+
+#endif // !SELFTEST_H
@@ -0,0 +1,48 @@
+#include "SessionArena.h"
+
+#include <algorithm>	// for max
+
+using namespace std;
+
+SessionArena::~SessionArena()
+{
+	for (const Block& block : blocks)
+		upstream->deallocate(block.data, block.size, alignof(max_align_t));
+}
+
+void* SessionArena::allocateSlow(size_t size, size_t alignment)
+{
+	// blocks kept from earlier sessions are reused in order before new ones are allocated
+	size_t candidate = next == nullptr ? current : current + 1;
+	for (; candidate < blocks.size(); ++candidate)
+	{
+		if (blocks[candidate].size >= size + alignment)
+			break;
+	}
+
+	if (candidate == blocks.size())
+	{
+		size_t length = max(blockSize, size + alignment);
+		blocks.push_back({ static_cast<char*>(upstream->allocate(length, alignof(max_align_t))), length });
+	}
+
+	current = candidate;
+	next = blocks[current].data;
+	end = next + blocks[current].size;
+	return allocate(size, alignment);
+}
+
+void SessionArena::reset()
+{
+	current = 0;
+	next = blocks.empty() ? nullptr : blocks[0].data;
+	end = blocks.empty() ? nullptr : blocks[0].data + blocks[0].size;
+}
+
+size_t SessionArena::getReservedBytes() const
+{
+	size_t total = 0;
+	for (const Block& block : blocks)
+		total += block.size;
+	return total;
+}
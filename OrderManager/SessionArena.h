@@ -0,0 +1,66 @@
+#ifndef SESSIONARENA_H
+#define SESSIONARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+/* Description - Bump allocator holding all the storage of one trading session.
+	 Memory is taken from large blocks of the upstream resource and never freed individually; reset() rewinds to the first block in O(1),
+	 without touching the objects, and keeps the blocks, so the next session starts on memory that is already faulted in.
+   Assumptions -
+	 1. Objects placed in the arena are either trivially destructible or own nothing outside it, so skipping their destructors is safe.
+	 2. Memory released during the session (rehashed bucket arrays, erased map nodes) is only reused after reset().
+*/
+class SessionArena : public std::pmr::memory_resource
+{
+	struct Block
+	{
+		char* data;
+		size_t size;
+	};
+
+	std::pmr::memory_resource* upstream;
+	std::vector<Block> blocks;
+	size_t current = 0;	// index of the block being filled
+	char* next = nullptr;
+	char* end = nullptr;
+	size_t blockSize;
+
+	void* allocateSlow(size_t size, size_t alignment);
+
+protected:
+	virtual void* do_allocate(size_t size, size_t alignment) override { return allocate(size, alignment); }
+	virtual void do_deallocate(void*, size_t, size_t) override {}
+	virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+	explicit SessionArena(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource(), size_t blockSize = 4 << 20) : upstream(upstream), blockSize(blockSize) {}
+	SessionArena(const SessionArena&) = delete;
+	SessionArena& operator=(const SessionArena&) = delete;
+	~SessionArena();
+
+	// same as memory_resource::allocate, without the virtual call
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+	{
+		size_t padding = static_cast<size_t>(0 - reinterpret_cast<uintptr_t>(next)) & (alignment - 1);
+		if (next != nullptr && static_cast<size_t>(end - next) >= size + padding)
+		{
+			void* result = next + padding;
+			next += padding + size;
+			return result;
+		}
+		return allocateSlow(size, alignment);
+	}
+
+	/* Description - Releases everything allocated since the last reset at once. Pointers into the arena become invalid.
+	*/
+	void reset();
+
+	/* Description - Bytes held in blocks, used or not.
+	*/
+	size_t getReservedBytes() const;
+};
+
+#endif // !SESSIONARENA_H
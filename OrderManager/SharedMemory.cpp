@@ -0,0 +1,170 @@
+#include "SharedMemory.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>	// for memset
+
+using namespace std;
+
+#if defined(_WIN32)
+
+bool SharedMemory::create(const string& regionName, size_t size)
+{
+	close();
+
+	unsigned long long size64 = size;
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), regionName.c_str());
+	if (mapping == nullptr)
+		return false;
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		// still open in another process, which would see it cleared under its feet (and its size can not change)
+		CloseHandle(mapping);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	memset(view, 0, size);
+	handle = mapping;
+	address = view;
+	length = size;
+	owner = true;
+	name = regionName;
+	return true;
+}
+
+bool SharedMemory::open(const string& regionName, size_t size)
+{
+	close();
+
+	HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, regionName.c_str());
+	if (mapping == nullptr)
+		return false;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	handle = mapping;
+	address = view;
+	length = size;
+	owner = false;
+	name = regionName;
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (address != nullptr)
+		UnmapViewOfFile(address);
+	if (handle != nullptr)
+		CloseHandle(handle);	// the mapping disappears with its last handle
+
+	address = nullptr;
+	handle = nullptr;
+	length = 0;
+	owner = false;
+}
+
+#else
+
+namespace
+{
+	// POSIX shared memory names must start with a single '/'
+	string posixName(const string& regionName)
+	{
+		return regionName.empty() || regionName[0] != '/' ? "/" + regionName : regionName;
+	}
+}
+
+bool SharedMemory::create(const string& regionName, size_t size)
+{
+	close();
+
+	string shmName = posixName(regionName);
+	int fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+
+	// truncating to 0 first discards the contents left by a previous owner
+	if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		::close(fd);
+		shm_unlink(shmName.c_str());
+		return false;
+	}
+
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+	{
+		shm_unlink(shmName.c_str());
+		return false;
+	}
+
+	address = view;
+	length = size;
+	owner = true;
+	name = shmName;
+	return true;
+}
+
+bool SharedMemory::open(const string& regionName, size_t size)
+{
+	close();
+
+	string shmName = posixName(regionName);
+	int fd = shm_open(shmName.c_str(), O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < size)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+		return false;
+
+	address = view;
+	length = size;
+	owner = false;
+	name = shmName;
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (address != nullptr)
+		munmap(address, length);
+	if (owner)
+		shm_unlink(name.c_str());
+
+	address = nullptr;
+	length = 0;
+	owner = false;
+}
+
+#endif
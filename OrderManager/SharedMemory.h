@@ -0,0 +1,46 @@
+#ifndef SHAREDMEMORY_H
+#define SHAREDMEMORY_H
+
+#include <cstddef>
+#include <string>
+
+/* Description - Named shared memory region visible to other processes on the box.
+	 Windows uses a pagefile-backed file mapping, other platforms POSIX shm_open + mmap.
+	 The creating process owns the name and removes it on destruction (POSIX); openers only unmap.
+*/
+class SharedMemory
+{
+	void* address = nullptr;
+	size_t length = 0;
+	bool owner = false;
+	std::string name;
+#if defined(_WIN32)
+	void* handle = nullptr;
+#endif
+
+	void close();
+
+public:
+	SharedMemory() = default;
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+	~SharedMemory() { close(); }
+
+	/* Description - Creates (or truncates) the region with the given size, zero filled.
+		 Returns false when the region can not be created or mapped.
+		 On Windows a mapping lives as long as a process has it open, so an existing one belongs to a live process and create fails;
+		 a POSIX region outlives its processes, so one left by a previous owner is truncated.
+	*/
+	bool create(const std::string& regionName, size_t size);
+
+	/* Description - Maps an existing region created by another process.
+		 Returns false when the region does not exist or is smaller than size.
+	*/
+	bool open(const std::string& regionName, size_t size);
+
+	void* data() const { return address; }
+	size_t size() const { return length; }
+	bool isOpen() const { return address != nullptr; }
+};
+
+#endif // !SHAREDMEMORY_H
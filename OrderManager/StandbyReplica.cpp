@@ -0,0 +1,119 @@
+#include "StandbyReplica.h"
+#include "Clock.h"
+
+using namespace std;
+
+namespace
+{
+	const int MaxHashReads = 1000;
+}
+
+bool StandbyReplica::open(const string& name)
+{
+	// map the header first to learn the capacity, then the whole journal
+	SharedMemory probe;
+	if (!probe.open(name, sizeof(JournalHeader)))
+		return false;
+
+	const JournalHeader* probeHeader = static_cast<const JournalHeader*>(probe.data());
+	atomic_thread_fence(memory_order_acquire);
+	if (probeHeader->magic != JournalMagic || probeHeader->capacity == 0)
+		return false;
+
+	if (!memory.open(name, journalSize(probeHeader->capacity)))
+		return false;
+
+	header = static_cast<JournalHeader*>(memory.data());
+	entries = reinterpret_cast<JournalEntry*>(static_cast<char*>(memory.data()) + sizeof(JournalHeader));
+	return true;
+}
+
+size_t StandbyReplica::poll(size_t maxEvents)
+{
+	if (header == nullptr || promoted || lostEvents)
+		return 0;
+
+	uint64_t published = header->writeSequence.load(memory_order_acquire);
+	size_t applied = 0;
+	while (appliedSequence < published && applied < maxEvents)
+	{
+		uint64_t next = appliedSequence + 1;
+		const JournalEntry& entry = entries[(next - 1) % header->capacity];
+
+		uint64_t before = entry.sequence.load(memory_order_acquire);
+		EventRecord event = entry.record;
+		atomic_thread_fence(memory_order_acquire);
+		uint64_t after = entry.sequence.load(memory_order_relaxed);
+
+		if (before != next || after != next)
+		{
+			// the writer has already reused the entry for a later event
+			lostEvents = true;
+			break;
+		}
+
+		applyEvent(manager, event);
+		appliedSequence = next;
+		++applied;
+
+		verifyStateHash();
+	}
+
+	// the hash of the last event is published after it, so it is usually found here rather than in the loop
+	if (verifiedSequence != appliedSequence)
+		verifyStateHash();
+	return applied;
+}
+
+void StandbyReplica::verifyStateHash()
+{
+	uint64_t lock = header->hashLock.load(memory_order_acquire);
+	if (lock & 1)
+		return;	// being written, checked again on a later event
+
+	uint64_t sequence = header->hashSequence.load(memory_order_relaxed);
+	if (sequence != appliedSequence)
+		return;
+
+	StateHash published;
+	published.low = header->hashLow.load(memory_order_relaxed);
+	published.high = header->hashHigh.load(memory_order_relaxed);
+	atomic_thread_fence(memory_order_acquire);
+	if (header->hashLock.load(memory_order_relaxed) != lock)
+		return;
+
+	if (published != manager.getStateHash())
+		diverged = true;
+	else
+		verifiedSequence = appliedSequence;
+}
+
+uint64_t StandbyReplica::getLag() const
+{
+	if (header == nullptr)
+		return 0;
+	return header->writeSequence.load(memory_order_acquire) - appliedSequence;
+}
+
+bool StandbyReplica::isPrimaryAlive(uint64_t timeoutNanos) const
+{
+	if (header == nullptr)
+		return false;
+	uint64_t last = header->heartbeatNanos.load(memory_order_relaxed);
+	uint64_t now = nowNanos();
+	return now < last || now - last <= timeoutNanos;
+}
+
+OrderManager* StandbyReplica::promote()
+{
+	poll();
+
+	// the hash may be being rewritten: read it again a bounded number of times
+	for (int attempt = 0; attempt < MaxHashReads && verifiedSequence != appliedSequence && !diverged && !lostEvents; ++attempt)
+		verifyStateHash();
+	if (lostEvents || diverged || verifiedSequence != appliedSequence)
+		return nullptr;
+
+	promoted = true;
+	return &manager;
+}
@@ -0,0 +1,78 @@
+#ifndef STANDBYREPLICA_H
+#define STANDBYREPLICA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "EventJournal.h"
+#include "OrderManager.h"
+#include "SharedMemory.h"
+
+/* Description - Hot-standby OrderManager that tails the primary's shared-memory journal and applies its events.
+	 The standby keeps a complete, up to date state, so promote() hands over a manager that can take over at once
+	 without rebuilding anything.
+   Assumptions -
+	 1. The standby is started with the journal, before the primary wraps around it; an empty state is the starting point.
+	 2. Lag is bounded by the journal capacity; a standby that falls further behind has lost events and must be resynchronised.
+*/
+class StandbyReplica
+{
+	SharedMemory memory;
+	JournalHeader* header = nullptr;
+	JournalEntry* entries = nullptr;
+
+	OrderManager manager;
+	uint64_t appliedSequence = 0;
+	uint64_t verifiedSequence = 0;	// last sequence at which the primary's hash matched, 0 for the empty starting state
+	bool lostEvents = false;
+	bool diverged = false;
+	bool promoted = false;
+
+	void verifyStateHash();
+
+public:
+	/* Description - Attaches to the named journal, returns false when it does not exist.
+	*/
+	bool open(const std::string& name);
+
+	/* Description - Applies up to maxEvents published events, returns the number applied. Never blocks.
+		 Also checks the state hash the primary published for the last applied event, which a caught-up standby only
+		 sees on a later poll, as the primary publishes it after the event.
+	*/
+	size_t poll(size_t maxEvents = SIZE_MAX);
+
+	/* Description - Sequence number of the last event applied (0 before the first).
+	*/
+	uint64_t getAppliedSequence() const { return appliedSequence; }
+
+	/* Description - Number of events published by the primary and not applied yet.
+	*/
+	uint64_t getLag() const;
+
+	/* Description - True when the primary published an event or heartbeat within the last timeoutNanos.
+	*/
+	bool isPrimaryAlive(uint64_t timeoutNanos) const;
+
+	/* Description - True when the standby fell more than the journal capacity behind and events were overwritten.
+	*/
+	bool hasLostEvents() const { return lostEvents; }
+
+	/* Description - True when a state hash published by the primary did not match the standby's state at the same sequence.
+	*/
+	bool hasDiverged() const { return diverged; }
+
+	/* Description - True when the state at getAppliedSequence() matched a hash published by the primary.
+	*/
+	bool isVerified() const { return verifiedSequence == appliedSequence; }
+
+	/* Description - Applies every remaining event, stops following the journal and returns the manager to run as primary.
+		 Returns nullptr, and keeps following, when the state can not be trusted (hasLostEvents() or hasDiverged()), or when it
+		 is not verified yet: the primary must have published its state hash after its last event (see JournalWriter::publishStateHash()).
+		 When the primary died before that, the new primary must be recovered from a checkpoint and the journal instead.
+	*/
+	OrderManager* promote();
+
+	const OrderManager& getManager() const { return manager; }
+};
+
+#endif // !STANDBYREPLICA_H
@@ -0,0 +1,123 @@
+#ifndef TEXTPARSING_H
+#define TEXTPARSING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/* Description - Allocation-free number parsing from a (pointer, length) field, for the text protocol and file parsers.
+	 They return false on an empty field, any unexpected character or overflow, and leave value untouched in that case.
+*/
+
+// Digits only, for fields that can not be negative (FIX tags and quantities)
+inline bool parseUnsigned(const char* p, size_t length, int& value)
+{
+	if (length == 0 || length > 10)
+		return false;
+
+	int64_t result = 0;
+	for (size_t i = 0; i < length; ++i)
+	{
+		unsigned digit = static_cast<unsigned>(p[i] - '0');
+		if (digit > 9)
+			return false;
+		result = result * 10 + digit;
+	}
+	if (result > INT32_MAX)
+		return false;
+
+	value = static_cast<int>(result);
+	return true;
+}
+
+// Optional leading '-', for signed fields such as a delta quantity
+inline bool parseInt(const char* p, size_t length, int& value)
+{
+	size_t i = 0;
+	bool negative = length > 0 && p[0] == '-';
+	if (negative)
+		++i;
+	if (i == length || length - i > 10)
+		return false;
+
+	int64_t result = 0;
+	for (; i < length; ++i)
+	{
+		unsigned digit = static_cast<unsigned>(p[i] - '0');
+		if (digit > 9)
+			return false;
+		result = result * 10 + digit;
+	}
+	if (negative)
+		result = -result;
+	if (result > INT32_MAX || result < INT32_MIN)
+		return false;
+
+	value = static_cast<int>(result);
+	return true;
+}
+
+// Decimal price to double without strtod, exact for up to 15 significant digits
+inline bool parsePrice(const char* p, size_t length, double& value)
+{
+	static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+	size_t i = 0;
+	bool negative = length > 0 && p[0] == '-';
+	if (negative)
+		++i;
+	if (i == length)
+		return false;
+
+	int64_t mantissa = 0;
+	int digits = 0;
+	int decimals = -1;	// -1 until the decimal point is seen
+	for (; i < length; ++i)
+	{
+		unsigned digit = static_cast<unsigned>(p[i] - '0');
+		if (digit <= 9)
+		{
+			if (++digits > 15)
+				return false;
+			mantissa = mantissa * 10 + digit;
+			if (decimals >= 0)
+				++decimals;
+		}
+		else if (p[i] == '.' && decimals < 0)
+		{
+			decimals = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	value = static_cast<double>(mantissa) / pow10[decimals < 0 ? 0 : decimals];
+	if (negative)
+		value = -value;
+	return true;
+}
+
+/* Description - Splits text into at most parts contiguous [begin, end) ranges that each start at the beginning of a line,
+	 so the ranges can be parsed independently and in parallel.
+*/
+inline std::vector<std::pair<size_t, size_t>> splitAtLineBoundaries(const char* text, size_t length, unsigned parts)
+{
+	std::vector<std::pair<size_t, size_t>> ranges;
+	size_t begin = 0;
+	for (unsigned part = 1; part <= parts && begin < length; ++part)
+	{
+		size_t end = part == parts ? length : length / parts * part;
+		if (end <= begin)
+			end = begin + 1;
+		while (end < length && text[end - 1] != '\n')
+			++end;
+		ranges.emplace_back(begin, end);
+		begin = end;
+	}
+	return ranges;
+}
+
+#endif // !TEXTPARSING_H
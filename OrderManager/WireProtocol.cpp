@@ -0,0 +1,65 @@
+#include "WireProtocol.h"
+
+using namespace std;
+
+namespace
+{
+	template <class T>
+	void wireWrite(char* p, T value)
+	{
+		memcpy(p, &value, sizeof(T));
+	}
+
+	char* writeHeader(char* out, uint16_t blockLength, uint16_t templateId)
+	{
+		wireWrite<uint16_t>(out, blockLength);
+		wireWrite<uint16_t>(out + 2, templateId);
+		wireWrite<uint16_t>(out + 4, WireSchemaId);
+		wireWrite<uint16_t>(out + 6, WireSchemaVersion);
+
+		char* body = out + WireHeaderLength;
+		memset(body, 0, blockLength);	// padding bytes are always zero
+		return body;
+	}
+}
+
+size_t encodeWireInsert(char* out, int id, char side, double price, int quantity)
+{
+	char* body = writeHeader(out, WireInsertBlockLength, WireInsert);
+	wireWrite<int32_t>(body, id);
+	wireWrite<int32_t>(body + 4, quantity);
+	wireWrite<double>(body + 8, price);
+	body[16] = side;
+	return WireHeaderLength + WireInsertBlockLength;
+}
+
+size_t encodeWireReplace(char* out, int oldId, int newId, int deltaQuantity)
+{
+	char* body = writeHeader(out, WireReplaceBlockLength, WireReplace);
+	wireWrite<int32_t>(body, oldId);
+	wireWrite<int32_t>(body + 4, newId);
+	wireWrite<int32_t>(body + 8, deltaQuantity);
+	return WireHeaderLength + WireReplaceBlockLength;
+}
+
+size_t encodeWireAck(char* out, int id)
+{
+	char* body = writeHeader(out, WireAckBlockLength, WireAck);
+	wireWrite<int32_t>(body, id);
+	return WireHeaderLength + WireAckBlockLength;
+}
+
+size_t encodeWireReject(char* out, int id)
+{
+	char* body = writeHeader(out, WireRejectBlockLength, WireReject);
+	wireWrite<int32_t>(body, id);
+	return WireHeaderLength + WireRejectBlockLength;
+}
+
+size_t encodeWireFill(char* out, int id, int quantityFilled)
+{
+	char* body = writeHeader(out, WireFillBlockLength, WireFill);
+	wireWrite<int32_t>(body, id);
+	wireWrite<int32_t>(body + 4, quantityFilled);
+	return WireHeaderLength + WireFillBlockLength;
+}
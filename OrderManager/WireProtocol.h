@@ -0,0 +1,127 @@
+#ifndef WIREPROTOCOL_H
+#define WIREPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>	// for memcpy
+#include "OrderListnerInterface.h"
+
+/* Description - SBE-style fixed-layout binary protocol carrying the Listener callbacks.
+	 Every message is an 8 byte header followed by a fixed-layout body of blockLength bytes.
+	 All fields are little-endian at fixed offsets, so they are read in place from the receive buffer.
+
+	 Header   : blockLength(uint16) templateId(uint16) schemaId(uint16) version(uint16)
+	 Insert   : id(int32 @0) quantity(int32 @4) price(double @8) side(char @16)	blockLength 24
+	 Replace  : oldId(int32 @0) newId(int32 @4) deltaQuantity(int32 @8)		blockLength 16
+	 Ack      : id(int32 @0)							blockLength 8
+	 Reject   : id(int32 @0)							blockLength 8
+	 Fill     : id(int32 @0) quantityFilled(int32 @4)				blockLength 8
+*/
+enum WireTemplateId : uint16_t { WireInsert = 1, WireReplace = 2, WireAck = 3, WireReject = 4, WireFill = 5 };
+
+const uint16_t WireSchemaId = 1;
+const uint16_t WireSchemaVersion = 1;
+const size_t WireHeaderLength = 8;
+
+const uint16_t WireInsertBlockLength = 24;
+const uint16_t WireReplaceBlockLength = 16;
+const uint16_t WireAckBlockLength = 8;
+const uint16_t WireRejectBlockLength = 8;
+const uint16_t WireFillBlockLength = 8;
+
+// block length of templateId in this schema version, 0 for an unknown template
+inline uint16_t wireBlockLength(uint16_t templateId)
+{
+	switch (templateId)
+	{
+	case WireInsert:
+		return WireInsertBlockLength;
+	case WireReplace:
+		return WireReplaceBlockLength;
+	case WireAck:
+		return WireAckBlockLength;
+	case WireReject:
+		return WireRejectBlockLength;
+	case WireFill:
+		return WireFillBlockLength;
+	default:
+		return 0;
+	}
+}
+
+template <class T>
+inline T wireRead(const char* p)
+{
+	// memcpy of a fixed size compiles to a single (unaligned) load
+	T value;
+	memcpy(&value, p, sizeof(T));
+	return value;
+}
+
+/* Description - Decodes a batch of wire messages in place and invokes the matching callback of handler per message.
+	 Handler is a template parameter so that a concrete manager is called directly rather than through the vtable.
+	 Returns the number of bytes consumed; a trailing partial message is left for the caller to complete with the next receive.
+	 Malformed messages (another schemaId, a version older than WireSchemaVersion, or a blockLength shorter than the fixed layout
+	 of their template) are skipped without invoking handler and counted in rejected when given, since the input is untrusted.
+   Assumptions -
+	 1. Messages with an unknown templateId are skipped using blockLength, and newer versions of the schema are decoded as long as
+	    their blockLength covers the fields above (newer versions may only append fields).
+	 2. Host byte order is little-endian (x86 / x64).
+*/
+template <class Handler>
+size_t decodeWireMessages(Handler& handler, const char* buffer, size_t length, size_t* rejected = nullptr)
+{
+	size_t offset = 0;
+	while (length - offset >= WireHeaderLength)
+	{
+		const char* header = buffer + offset;
+		uint16_t blockLength = wireRead<uint16_t>(header);
+		if (length - offset - WireHeaderLength < blockLength)
+			break;	// partial message
+		offset += WireHeaderLength + blockLength;
+
+		uint16_t templateId = wireRead<uint16_t>(header + 2);
+		if (wireRead<uint16_t>(header + 4) != WireSchemaId || wireRead<uint16_t>(header + 6) < WireSchemaVersion || blockLength < wireBlockLength(templateId))
+		{
+			if (rejected != nullptr)
+				++*rejected;
+			continue;
+		}
+
+		const char* body = header + WireHeaderLength;
+		switch (templateId)
+		{
+		case WireInsert:
+			handler.OnInsertOrderRequest(wireRead<int32_t>(body), body[16], wireRead<double>(body + 8), wireRead<int32_t>(body + 4));
+			break;
+		case WireReplace:
+			handler.OnReplaceOrderRequest(wireRead<int32_t>(body), wireRead<int32_t>(body + 4), wireRead<int32_t>(body + 8));
+			break;
+		case WireAck:
+			handler.OnRequestAcknowledged(wireRead<int32_t>(body));
+			break;
+		case WireReject:
+			handler.OnRequestRejected(wireRead<int32_t>(body));
+			break;
+		case WireFill:
+			handler.OnOrderFilled(wireRead<int32_t>(body), wireRead<int32_t>(body + 4));
+			break;
+		default:
+			// unknown template, skip it
+			break;
+		}
+	}
+	return offset;
+}
+
+/* Description - Encoders for the wire messages above, used by simulators, journal writers and benchmarks.
+	 Each writes one complete message at out and returns its length in bytes.
+	 out must have room for WireHeaderLength + blockLength of the message.
+*/
+size_t encodeWireInsert(char* out, int id, char side, double price, int quantity);
+size_t encodeWireReplace(char* out, int oldId, int newId, int deltaQuantity);
+size_t encodeWireAck(char* out, int id);
+size_t encodeWireReject(char* out, int id);
+size_t encodeWireFill(char* out, int id, int quantityFilled);
+
+#endif // !WIREPROTOCOL_H